@@ -60,6 +60,7 @@ tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const span<char
 {
   TCPConfig c_fsm {};
   c_fsm.isn = Wrap32 { random_device()() };
+  c_fsm.max_send_capacity = 4 << 20; // let the bytes in flight fill a large (scaled) window
 
   FdAdapterConfig c_filt {};
   const char* tundev = nullptr;
@@ -1,5 +1,6 @@
 #include "socket.hh"
 #include "tcp_minnow_socket.hh"
+#include <array>
 #include <cstdlib>
 #include <iostream>
 #include <span>
@@ -17,11 +18,11 @@ void get_URL( const string& host, const string& path )
   // 构造 HTTP GET 请求
   string request = "GET " + path + " HTTP/1.1\r\n" + "Host: " + host + "\r\n" + "Connection: close\r\n\r\n";
   sock.write( request );
-  // 接收响应
-  string res;
+  // 接收响应：直接读进固定大小的缓冲区，不需要每次构造临时string
+  array<char, 16384> buf {};
   while ( !sock.eof() ) {
-    sock.read( res );
-    cout << res;
+    const size_t n = sock.read( span { buf } );
+    cout.write( buf.data(), static_cast<streamsize>( n ) );
   }
   sock.close();
 }
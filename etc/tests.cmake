@@ -23,6 +23,10 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_chunked)
+ttest(byte_stream_peek_iov)
+ttest(byte_stream_fd)
+ttest(spsc_byte_stream)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -45,6 +49,16 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_sack)
+ttest(recv_timestamps)
+ttest(recv_autotune)
+ttest(tcp_segment_options)
+ttest(tcp_window_scale)
+ttest(tcp_delayed_ack)
+ttest(tcp_close)
+ttest(tcp_sack_negotiation)
+ttest(tcp_effective_mss)
+ttest(tcp_minnow_direct)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +67,15 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_sack)
+ttest(send_congestion)
+ttest(send_rto)
+ttest(send_fast_retx)
+ttest(send_rack_tlp)
+ttest(send_pacing)
+ttest(send_mtu_probe)
+ttest(send_persist)
+ttest(send_nagle)
 
 ttest(net_interface)
 
@@ -89,4 +112,7 @@ set_property(TEST ${compile_name_opt} PROPERTY TIMEOUT 0)
 set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
+stest(sender_speed_test)
 stest(reassembler_speed_test)
+stest(congestion_control_speed_test)
+stest(loss_recovery_speed_test)
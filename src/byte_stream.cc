@@ -1,8 +1,153 @@
 #include "byte_stream.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unistd.h>
+#include <utility>
 
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ) {}
+static constexpr uint64_t kPipeReadSize = 16384;  // Pipe模式下peek()每次从pipe中读出的最大字节数
+static constexpr uint64_t kChunkReadSize = 16384; // Chunked模式下write_from()每次最多读的字节数
+static constexpr uint64_t kMinRingSize = 4096;     // Ring模式第一次分配的环形缓冲区大小（capacity更小时取capacity）
+
+struct ByteStream::Pipe
+{
+  FileDescriptor read_end;
+  FileDescriptor write_end;
+  deque<string> staged {};   // peek()已经从pipe中读出、但还没有被pop的字节，每次读出的一段是一个chunk
+  uint64_t staged_offset {}; // staged.front()中已经被pop的字节数
+  uint64_t staged_bytes {};  // staged中还没有被pop的字节数
+  bool full {};              // pipe已经写不进去了（splice进来的数据不能合并，pipe可能在达到capacity之前就满了）
+  string unpiped {};         // 已经push、但pipe的页槽被splice进来的小块占满而写不进去的字节，排在pipe中所有字节之后
+
+  // 从pipe中再读出最多kPipeReadSize个字节，作为一个新的chunk追加到staged。
+  // 已有的chunk不会被移动或修改，所以之前peek()返回的string_view在这些字节被pop之前一直有效
+  // pipe已经读空时，剩下的字节都在unpiped中，整个作为一个chunk
+  void stage( uint64_t unstaged )
+  {
+    string chunk( min( unstaged, kPipeReadSize ), 0 );
+    chunk.resize( read_end.read( span { chunk } ) );
+    if ( chunk.empty() ) {
+      chunk = exchange( unpiped, {} );
+    }
+    if ( chunk.empty() ) {
+      throw runtime_error( "ByteStream pipe holds fewer bytes than buffered" );
+    }
+    staged_bytes += chunk.size();
+    staged.push_back( move( chunk ) );
+  }
+
+  // 把data写进pipe（非阻塞），写不进去的部分留在unpiped中；unpiped不为空时直接追加，保证字节的顺序
+  void write( string_view data )
+  {
+    if ( unpiped.empty() ) {
+      const ssize_t written = ::write( write_end.fd_num(), data.data(), data.size() );
+      if ( written < 0 && errno != EAGAIN ) {
+        throw unix_error { "write" };
+      }
+      data.remove_prefix( max( written, ssize_t { 0 } ) );
+    }
+    unpiped.append( data );
+  }
+
+  // pipe腾出空间以后，把unpiped中的字节写回pipe
+  void flush_unpiped()
+  {
+    if ( !unpiped.empty() ) {
+      write( exchange( unpiped, {} ) );
+    }
+  }
+
+  // 让pipe能放下capacity个字节，返回实际能保证的容量。
+  // 一个读了一部分的页仍然占着一个页槽，所以要多留一页：能保证的容量是(页槽数 - 1) * 页大小
+  uint64_t resize( uint64_t capacity ) const
+  {
+    const auto page = static_cast<uint64_t>( ::sysconf( _SC_PAGESIZE ) );
+    const int fd = write_end.fd_num();
+    const auto request = static_cast<int>( min( capacity + page, uint64_t { INT_MAX } ) );
+    // 没有特权时超过/proc/sys/fs/pipe-max-size会失败（EPERM），这时退而求其次，按允许的最大值再试一次；
+    // 还是失败（比如超过了用户的pipe总页数限制）就保留原来的大小
+    if ( ::fcntl( fd, F_SETPIPE_SZ, request ) < 0 && errno == EPERM ) { // NOLINT(*-vararg)
+      int max_size = 0;
+      ifstream { "/proc/sys/fs/pipe-max-size" } >> max_size;
+      if ( max_size > 0 && max_size < request ) {
+        ::fcntl( fd, F_SETPIPE_SZ, max_size ); // NOLINT(*-vararg)
+      }
+    }
+    const int pipe_size = CheckSystemCall( "fcntl", ::fcntl( fd, F_GETPIPE_SZ ) );              // NOLINT(*-vararg)
+    return min( capacity, static_cast<uint64_t>( pipe_size ) - page );
+  }
+};
+
+ByteStream::PipeHandle::PipeHandle() = default;
+ByteStream::PipeHandle::PipeHandle( unique_ptr<Pipe> pipe ) : pipe_( move( pipe ) ) {}
+
+ByteStream::PipeHandle::PipeHandle( PipeHandle&& other ) noexcept = default;
+ByteStream::PipeHandle& ByteStream::PipeHandle::operator=( PipeHandle&& other ) noexcept = default;
+ByteStream::PipeHandle::~PipeHandle() = default;
+
+// 环形缓冲区在第一次push时才分配，之后按需成倍增长，最大是不小于capacity的2的幂，这样下标只需要和mask做与运算
+// Chunked模式不需要环形缓冲区，直接保存push进来的string
+// Pipe模式把数据放在内核pipe中，capacity不能超过pipe的实际大小
+ByteStream::ByteStream( uint64_t capacity, Mode mode ) : capacity_( capacity ), mode_( mode )
+{
+  if ( mode_ == Mode::Pipe ) {
+    array<int, 2> fds {};
+    CheckSystemCall( "pipe2", ::pipe2( fds.data(), O_NONBLOCK | O_CLOEXEC ) );
+    pipe = PipeHandle { make_unique<Pipe>( FileDescriptor { fds[0] }, FileDescriptor { fds[1] } ) };
+    capacity_ = pipe->resize( capacity_ );
+  }
+}
+// 让环形缓冲区至少能放下needed个字节：大小至少翻倍（第一次分配kMinRingSize），但不超过capacity对应的2的幂。
+// 换一个更大的缓冲区时，已有的字节搬到新缓冲区中对应的位置（下标不变，只是mask变了）
+void ByteStream::reserve_ring( uint64_t needed )
+{
+  if ( needed <= buffer.size() ) {
+    return;
+  }
+  // bit_ceil的结果超过2^63时没有定义，所以先把capacity限制在2^63以内（这么大的缓冲区本来也分配不出来）
+  const uint64_t largest = bit_ceil( min( max( capacity_, uint64_t { 1 } ), uint64_t { 1 } << 63 ) );
+  const uint64_t size = min( max( { buffer.size() * 2, kMinRingSize, bit_ceil( needed ) } ), largest );
+  if ( size <= buffer.size() ) {
+    return;
+  }
+  vector<char> bigger( size );
+  const uint64_t bigger_mask = bigger.size() - 1;
+  // 每次拷贝一段在新旧缓冲区中都连续的区域
+  for ( uint64_t i = total_bytes_poped; i < total_bytes_pushed; ) {
+    const uint64_t from = i & mask;
+    const uint64_t to = i & bigger_mask;
+    const uint64_t len = min( { total_bytes_pushed - i, buffer.size() - from, bigger.size() - to } );
+    memcpy( bigger.data() + to, buffer.data() + from, len );
+    i += len;
+  }
+  buffer = move( bigger );
+  mask = bigger_mask;
+}
+// 提高容量：Ring模式只改capacity，环形缓冲区等到真的需要时再变大；Pipe模式尝试把pipe调大
+void ByteStream::grow( uint64_t capacity )
+{
+  if ( capacity <= capacity_ ) {
+    return;
+  }
+  if ( mode_ == Mode::Pipe ) {
+    capacity = pipe->resize( capacity );
+    pipe->full = false;
+    pipe->flush_unpiped();
+  }
+  capacity_ = max( capacity_, capacity );
+}
 // 返回stream是否关闭
 bool Writer::is_closed() const
 {
@@ -15,15 +160,31 @@ void Writer::push( string data )
 {
   // Your code here.
   // (void)data;
-  uint64_t len = data.length();
-  if ( len > capacity_ - buffer.size() ) {
-    len = capacity_ - buffer.size();
+  const uint64_t len = min( data.length(), available_capacity() );
+  if ( len == 0 ) {
+    return;
   }
-  for ( uint64_t i = 0; i < len; ++i ) {
-    buffer.push_back( data[i] );
-    total_bytes_pushed++;
+  // Chunked模式：截断到可用容量后直接把string移动进队列，不做拷贝
+  if ( mode_ == Mode::Chunked ) {
+    data.resize( len );
+    chunk_starts.push_back( total_bytes_pushed );
+    chunks.push_back( move( data ) );
+    total_bytes_pushed += len;
+    return;
   }
-  return;
+  // Pipe模式：直接写进pipe，pipe写不下的部分先留在unpiped中
+  if ( mode_ == Mode::Pipe ) {
+    pipe->write( string_view { data }.substr( 0, len ) );
+    total_bytes_pushed += len;
+    return;
+  }
+  // 写入位置到缓冲区末尾之间先拷贝一段，剩下的绕回缓冲区开头再拷贝
+  reserve_ring( total_bytes_pushed - total_bytes_poped + len );
+  const uint64_t start = total_bytes_pushed & mask;
+  const uint64_t first = min( len, buffer.size() - start );
+  memcpy( buffer.data() + start, data.data(), first );
+  memcpy( buffer.data(), data.data() + first, len - first );
+  total_bytes_pushed += len;
 }
 // 关闭stream
 void Writer::close()
@@ -31,11 +192,67 @@ void Writer::close()
   closed = true;
   // Your code here.
 }
+// 从fd直接读入stream的空闲空间，返回读到的字节数
+// Ring模式用readv一次填满两段空闲区域（绕回前、绕回后），不需要临时string
+// Chunked模式直接读进一个新的string，截短到读到的长度后移动进队列，不再拷贝一次。截短不会释放多出来的内存，
+// 所以每次最多读kChunkReadSize个字节：用多一些read调用换取每个chunk最多多占用kChunkReadSize个字节
+// Pipe模式用splice在内核中直接把数据从fd移到pipe；fd不支持splice时（EINVAL，比如终端）、
+// 或者还有字节留在unpiped中（新数据必须排在它们后面）时，先读进重复使用的scratch，再写进pipe
+uint64_t Writer::write_from( FileDescriptor& fd )
+{
+  const uint64_t free = available_capacity();
+  if ( free == 0 ) {
+    return 0;
+  }
+  if ( mode_ == Mode::Pipe && pipe->unpiped.empty() ) {
+    try {
+      const uint64_t len = fd.splice_to( pipe->write_end, free );
+      // 什么都没移动、也没有EOF：如果pipe中还有数据，说明是pipe满了（pipe为空时只可能是fd暂时没有数据）
+      pipe->full = len == 0 && !fd.eof() && total_bytes_pushed != total_bytes_poped;
+      total_bytes_pushed += len;
+      return len;
+    } catch ( const unix_error& e ) {
+      if ( e.error_code() != EINVAL ) {
+        throw;
+      }
+    }
+  }
+  if ( mode_ == Mode::Chunked ) {
+    string chunk( min( free, kChunkReadSize ), 0 );
+    chunk.resize( fd.read( span { chunk } ) );
+    const uint64_t len = chunk.size();
+    push( move( chunk ) );
+    return len;
+  }
+  if ( mode_ == Mode::Pipe ) {
+    if ( scratch.size() < free ) {
+      scratch.resize( free );
+    }
+    const uint64_t len = fd.read( span { scratch.data(), free } );
+    pipe->write( string_view { scratch }.substr( 0, len ) );
+    total_bytes_pushed += len;
+    return len;
+  }
+  // 缓冲区已经用了一半以上时先让它变大，然后只读到缓冲区中还空着的地方
+  const uint64_t buffered = total_bytes_pushed - total_bytes_poped;
+  if ( buffered * 2 >= buffer.size() ) {
+    reserve_ring( buffer.size() + 1 );
+  }
+  const uint64_t room = min( free, buffer.size() - buffered );
+  const uint64_t start = total_bytes_pushed & mask;
+  const uint64_t first = min( room, buffer.size() - start );
+  const uint64_t len = fd.read( { span { buffer.data() + start, first }, span { buffer.data(), room - first } } );
+  total_bytes_pushed += len;
+  return len;
+}
 // 返回capacity - 已经用过的stream大小
 uint64_t Writer::available_capacity() const
 {
   // Your code here.
-  return capacity_ - buffer.size();
+  if ( mode_ == Mode::Pipe && pipe->full ) {
+    return 0;
+  }
+  return capacity_ - ( total_bytes_pushed - total_bytes_poped );
 }
 // 返回总的push进stream的字节数
 uint64_t Writer::bytes_pushed() const
@@ -48,7 +265,7 @@ uint64_t Writer::bytes_pushed() const
 bool Reader::is_finished() const
 {
   // Your code here.
-  return closed && buffer.empty();
+  return closed && total_bytes_pushed == total_bytes_poped;
 }
 // 返回总的pop的stream的字节数
 uint64_t Reader::bytes_popped() const
@@ -58,30 +275,208 @@ uint64_t Reader::bytes_popped() const
 }
 // Peek at the next bytes in the buffer
 // string_view: C++ 17引入，在不拷贝的情况下读取、查看和操作字符串
-// peek函数作用：
+// peek函数作用：返回从读位置开始、到缓冲区末尾或写位置为止的最长连续区域
 string_view Reader::peek() const
 {
   // Your code here.
-  if ( !buffer.empty() ) {
-    return std::string_view( &buffer.front(), 1 ); // 返回deque的front元素的string_view
+  if ( mode_ == Mode::Chunked ) {
+    if ( chunks.empty() ) {
+      return {};
+    }
+    return string_view { chunks.front() }.substr( chunk_offset );
+  }
+  // Pipe模式：pipe中的数据无法直接查看，先读出一段放进staged（逻辑上是const：buffered的字节没有变化）
+  if ( mode_ == Mode::Pipe ) {
+    Pipe& p = *pipe;
+    if ( p.staged_bytes == 0 && bytes_buffered() > 0 ) {
+      p.stage( bytes_buffered() );
+    }
+    if ( p.staged.empty() ) {
+      return {};
+    }
+    return string_view { p.staged.front() }.substr( p.staged_offset );
+  }
+  const uint64_t start = total_bytes_poped & mask;
+  const uint64_t len = min( bytes_buffered(), buffer.size() - start );
+  return { buffer.data() + start, len };
+}
+// 跳过最前面的offset个字节（不pop），返回之后的最长连续区域，offset不小于bytes_buffered()时返回空
+// TCPSender用它把未确认的数据留在stream中，重传时再从这里取出
+string_view Reader::peek_at( uint64_t offset ) const
+{
+  if ( offset >= bytes_buffered() ) {
+    return {};
+  }
+  if ( mode_ == Mode::Chunked ) {
+    const auto [index, skip] = locate_chunk( offset );
+    return string_view { chunks[index] }.substr( skip );
+  }
+  // Pipe模式：把pipe中的数据继续读进staged，直到覆盖offset，然后像Chunked模式一样找到offset所在的chunk
+  if ( mode_ == Mode::Pipe ) {
+    Pipe& p = *pipe;
+    while ( p.staged_bytes <= offset ) {
+      p.stage( bytes_buffered() - p.staged_bytes );
+    }
+    offset += p.staged_offset;
+    for ( const auto& chunk : p.staged ) {
+      if ( offset < chunk.size() ) {
+        return string_view { chunk }.substr( offset );
+      }
+      offset -= chunk.size();
+    }
+    return {};
+  }
+  const uint64_t start = ( total_bytes_poped + offset ) & mask;
+  const uint64_t len = min( bytes_buffered() - offset, buffer.size() - start );
+  return { buffer.data() + start, len };
+}
+// chunk_starts记录每个chunk第一个字节在整个stream中的位置，是递增的，所以可以二分查找，
+// 每次peek_at()是O(log n)，而不用从队首逐个chunk减去长度
+pair<size_t, uint64_t> ByteStream::locate_chunk( uint64_t offset ) const
+{
+  const uint64_t index = total_bytes_poped + offset;
+  const auto it = prev( upper_bound( chunk_starts.begin(), chunk_starts.end(), index ) );
+  return { static_cast<size_t>( it - chunk_starts.begin() ), index - *it };
+}
+// 把从offset开始的最多len个字节拷贝到一个string中（不pop），只分配一次内存
+// Chunked模式用locate_chunk()二分查找起点所在的chunk，之后逐个chunk整段拷贝；Ring模式最多拷贝两段
+string Reader::slice( uint64_t offset, uint64_t len ) const
+{
+  if ( offset >= bytes_buffered() ) {
+    return {};
+  }
+  len = min( len, bytes_buffered() - offset );
+  string out;
+  out.reserve( len );
+  if ( mode_ == Mode::Chunked ) {
+    auto [index, skip] = locate_chunk( offset );
+    for ( ; out.size() < len; ++index, skip = 0 ) {
+      out.append( chunks[index], skip, len - out.size() );
+    }
+    return out;
+  }
+  while ( out.size() < len ) {
+    out += peek_at( offset + out.size() ).substr( 0, len - out.size() );
+  }
+  return out;
+}
+// 返回最多max_views段连续区域，依次覆盖缓冲区中的数据，便于一次writev写出
+// Ring模式最多两段（绕回前、绕回后），Chunked模式每个chunk一段，Pipe模式只有peek()的一段
+vector<string_view> Reader::peek_iov( size_t max_views ) const
+{
+  vector<string_view> views;
+  if ( max_views == 0 || bytes_buffered() == 0 ) {
+    return views;
+  }
+  if ( mode_ == Mode::Pipe ) {
+    views.push_back( peek() );
+    return views;
+  }
+  if ( mode_ == Mode::Chunked ) {
+    views.reserve( min( max_views, chunks.size() ) );
+    views.push_back( peek() );
+    for ( auto it = chunks.begin() + 1; it != chunks.end() && views.size() < max_views; ++it ) {
+      views.emplace_back( *it );
+    }
+    return views;
+  }
+  views.push_back( peek() );
+  if ( views.front().size() < bytes_buffered() && max_views > 1 ) {
+    views.emplace_back( buffer.data(), bytes_buffered() - views.front().size() );
+  }
+  return views;
+}
+// 把尽可能多的字节拷贝到out中并pop掉，返回拷贝的字节数
+// 还有数据却peek()不出来时抛出异常，而不是一直循环
+uint64_t Reader::read_into( span<char> out )
+{
+  uint64_t copied = 0;
+  while ( copied < out.size() && bytes_buffered() > 0 ) {
+    const string_view view = peek().substr( 0, out.size() - copied );
+    if ( view.empty() ) {
+      throw runtime_error( "Reader::peek() returned empty string_view" );
+    }
+    memcpy( out.data() + copied, view.data(), view.size() );
+    copied += view.size();
+    pop( view.size() );
+  }
+  return copied;
+}
+// 把缓冲区中的数据写到fd并pop掉，返回写出的字节数
+// Pipe模式下如果没有peek()读出的数据，就用splice直接把pipe中的数据移到fd
+uint64_t Reader::write_to( FileDescriptor& fd )
+{
+  if ( bytes_buffered() == 0 ) {
+    return 0;
+  }
+  if ( mode_ == Mode::Pipe && pipe->staged_bytes == 0 ) {
+    try {
+      pipe->flush_unpiped();
+      const uint64_t len = pipe->read_end.splice_to( fd, bytes_buffered() );
+      total_bytes_poped += len;
+      pipe->full = pipe->full && len == 0;
+      pipe->flush_unpiped();
+      return len;
+    } catch ( const unix_error& e ) {
+      if ( e.error_code() != EINVAL ) {
+        throw;
+      }
+    }
   }
-  return std::string_view(); // 返回一个默认构造的string_view（空的）
+  const uint64_t len = fd.write( peek_iov() );
+  pop( len );
+  return len;
 }
 //
 void Reader::pop( uint64_t len )
 {
   // Your code here.
-  if ( buffer.size() < len ) {
-    len = buffer.size();
+  len = min( len, bytes_buffered() );
+  total_bytes_poped += len;
+  // Chunked模式：用chunk_offset记录队首chunk已经pop的部分，整个chunk被pop完才出队
+  while ( mode_ == Mode::Chunked && len > 0 ) {
+    const uint64_t n = min( len, chunks.front().size() - chunk_offset );
+    chunk_offset += n;
+    len -= n;
+    if ( chunk_offset == chunks.front().size() ) {
+      chunks.pop_front();
+      chunk_starts.pop_front();
+      chunk_offset = 0;
+    }
   }
-  for ( uint64_t i = 0; i < len; ++i ) {
-    buffer.pop_front();
-    total_bytes_poped++;
+  // Pipe模式：先pop掉staged中的字节，剩下的还在pipe中，读出来丢掉
+  if ( mode_ == Mode::Pipe && len > 0 ) {
+    Pipe& p = *pipe;
+    p.full = false;
+    while ( len > 0 && p.staged_bytes > 0 ) {
+      const uint64_t n = min( len, p.staged.front().size() - p.staged_offset );
+      p.staged_offset += n;
+      p.staged_bytes -= n;
+      len -= n;
+      if ( p.staged_offset == p.staged.front().size() ) {
+        p.staged.pop_front();
+        p.staged_offset = 0;
+      }
+    }
+    string discard;
+    while ( len > 0 ) {
+      discard.resize( min( len, kPipeReadSize ) );
+      uint64_t discarded = p.read_end.read( span { discard } );
+      if ( discarded == 0 ) {
+        discarded = min( len, static_cast<uint64_t>( p.unpiped.size() ) );
+        p.unpiped.erase( 0, discarded );
+      }
+      if ( discarded == 0 ) {
+        throw runtime_error( "ByteStream pipe holds fewer bytes than buffered" );
+      }
+      len -= discarded;
+    }
+    p.flush_unpiped();
   }
 }
 // Number of bytes currently buffered (pushed and not popped)
 uint64_t Reader::bytes_buffered() const
 {
   // Your code here.
-  return buffer.size();
+  return total_bytes_pushed - total_bytes_poped;
 }
\ No newline at end of file
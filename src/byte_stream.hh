@@ -2,15 +2,42 @@
 
 #include <cstdint>
 #include <deque>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 class Reader;
 class Writer;
+class FileDescriptor;
 
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity );
+  // How the stream stores buffered bytes:
+  //   Ring:    bytes are copied into a ring buffer; peek() returns the largest contiguous region. The buffer is
+  //            allocated on the first push and doubles as needed, up to the capacity rounded up to a power of two.
+  //   Chunked: pushed strings are kept as-is (no copy); peek() returns the rest of the front chunk.
+  //   Pipe:    bytes live in a kernel pipe, so Writer::write_from and Reader::write_to can splice(2) them
+  //            between file descriptors without copying through user space. The capacity is clamped to
+  //            what the pipe can hold with one page slot to spare (a partly read page still takes a slot).
+  //            peek(), peek_at() and slice() read bytes out of the pipe into a staging area, so even these
+  //            const methods make system calls.
+  //
+  // A ByteStream cannot be copied, only moved.
+  //
+  // In every mode, a view returned by peek(), peek_at() or peek_iov() stays valid until its bytes are popped
+  // or the stream is grown, moved or destroyed. In Ring mode, a push() or write_from() that enlarges the ring
+  // buffer also invalidates it.
+  enum class Mode : uint8_t
+  {
+    Ring,
+    Chunked,
+    Pipe,
+  };
+
+  explicit ByteStream( uint64_t capacity, Mode mode = Mode::Ring );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -21,6 +48,10 @@ public:
   void set_error() { error_ = true; };       // Signal that the stream suffered an error.
   bool has_error() const { return error_; }; // Has the stream had an error?
 
+  // Raise the capacity to `capacity` (never lowers it; a Pipe-mode stream stops at what the pipe can hold)
+  void grow( uint64_t capacity );
+  uint64_t capacity() const { return capacity_; }
+
 protected:
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   uint64_t capacity_;
@@ -28,9 +59,44 @@ protected:
 
   // my code here
   bool closed = false;
-  uint64_t total_bytes_pushed = 0;
-  uint64_t total_bytes_poped = 0;
-  std::deque<char> buffer = {};
+  uint64_t total_bytes_pushed = 0; // also the (unmasked) write index into the ring buffer
+  uint64_t total_bytes_poped = 0;  // also the (unmasked) read index into the ring buffer
+  std::vector<char> buffer = {};   // ring buffer, allocated on first push and grown up to bit_ceil(capacity_)
+  uint64_t mask = 0;               // buffer.size() - 1
+
+  void reserve_ring( uint64_t needed ); // Ring mode: grow the ring buffer to hold at least `needed` bytes
+
+  Mode mode_;                             // Ring, Chunked or Pipe storage
+  std::deque<std::string> chunks = {};    // Chunked mode: strings moved in by push()
+  std::deque<uint64_t> chunk_starts = {}; // Chunked mode: stream index of each chunk's first byte (ascending)
+  uint64_t chunk_offset = 0;              // Chunked mode: bytes already popped from chunks.front()
+  std::string scratch = {};               // Pipe mode without splice: write_from() reads here
+
+  // Chunked mode: index of the chunk holding the byte `offset` past the read position, and that byte's
+  // offset within the chunk (binary search over chunk_starts; `offset` must be less than bytes_buffered())
+  std::pair<size_t, uint64_t> locate_chunk( uint64_t offset ) const;
+
+  struct Pipe; // Pipe mode: the pipe's two ends, plus bytes read out of it by peek()
+
+  // Owns the Pipe. It cannot be copied, so neither can a ByteStream (in any mode); it can only be moved.
+  class PipeHandle
+  {
+  public:
+    PipeHandle();
+    explicit PipeHandle( std::unique_ptr<Pipe> pipe );
+    PipeHandle( const PipeHandle& other ) = delete;
+    PipeHandle& operator=( const PipeHandle& other ) = delete;
+    PipeHandle( PipeHandle&& other ) noexcept;
+    PipeHandle& operator=( PipeHandle&& other ) noexcept;
+    ~PipeHandle();
+
+    Pipe& operator*() const { return *pipe_; }
+    Pipe* operator->() const { return pipe_.get(); }
+
+  private:
+    std::unique_ptr<Pipe> pipe_ {};
+  };
+  PipeHandle pipe = {}; // Pipe mode only
 };
 
 class Writer : public ByteStream
@@ -39,6 +105,9 @@ public:
   void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
   void close();                  // Signal that the stream has reached its ending. Nothing more will be written.
 
+  // Read from `fd` directly into the stream's free space; returns the number of bytes read
+  uint64_t write_from( FileDescriptor& fd );
+
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
@@ -47,9 +116,23 @@ public:
 class Reader : public ByteStream
 {
 public:
-  std::string_view peek() const; // Peek at the next bytes in the buffer
+  std::string_view peek() const; // Peek at the next bytes in the buffer (largest contiguous region)
+  // Peek at the bytes `offset` past the next one, without popping the ones before (largest contiguous region)
+  std::string_view peek_at( uint64_t offset ) const;
+  // Copy up to `len` bytes starting `offset` past the next one into a single string, without popping
+  std::string slice( uint64_t offset, uint64_t len ) const;
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
+  // Peek at up to `max_views` consecutive regions of the buffer, in order (e.g., for a vectored write)
+  std::vector<std::string_view> peek_iov( size_t max_views = 64 ) const;
+
+  // Copy (and pop) as many bytes as fit into `out`; returns the number of bytes copied
+  // (throws if peek() returns nothing while bytes are buffered)
+  uint64_t read_into( std::span<char> out );
+
+  // Write (and pop) buffered bytes to `fd`; returns the number of bytes written
+  uint64_t write_to( FileDescriptor& fd );
+
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
   uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
@@ -1,7 +1,7 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
 #include <cstdint>
-#include <stdexcept>
 
 /*
  * read: A helper function thats peeks and pops up to `len` bytes
@@ -9,19 +9,8 @@
  */
 void read( Reader& reader, uint64_t len, std::string& out )
 {
-  out.clear();
-
-  while ( reader.bytes_buffered() and out.size() < len ) {
-    auto view = reader.peek();
-
-    if ( view.empty() ) {
-      throw std::runtime_error( "Reader::peek() returned empty string_view" );
-    }
-
-    view = view.substr( 0, len - out.size() ); // Don't return more bytes than desired.
-    out += view;
-    reader.pop( view.size() );
-  }
+  out.resize( std::min( len, reader.bytes_buffered() ) ); // Don't return more bytes than desired.
+  out.resize( reader.read_into( out ) );
 }
 
 Reader& ByteStream::reader()
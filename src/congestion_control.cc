@@ -0,0 +1,284 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// RFC 6928的初始窗口 min(10 * MSS, max(2 * MSS, 14600))，把10换成initial_window：
+// MSS很大时按每个segment 1460字节计算，但至少两个segment
+uint64_t initial_cwnd( uint64_t mss, uint64_t initial_window )
+{
+  return max( min( initial_window * mss, max( 2 * mss, initial_window * 1460 ) ), mss );
+}
+
+} // namespace
+
+CongestionController::CongestionController( uint64_t mss, uint64_t initial_window )
+  : mss_( mss ), initial_window_( initial_window ), cwnd_( initial_cwnd( mss, initial_window ) )
+{}
+
+void CongestionController::set_initial_mss( uint64_t mss )
+{
+  mss_ = mss;
+  cwnd_ = initial_cwnd( mss, initial_window_ );
+}
+
+unique_ptr<CongestionController> make_congestion_controller( TCPConfig::CongestionControl algorithm,
+                                                             uint64_t mss,
+                                                             uint64_t initial_window )
+{
+  switch ( algorithm ) {
+    case TCPConfig::CongestionControl::Reno:
+      return make_unique<RenoController>( mss, initial_window );
+    case TCPConfig::CongestionControl::Cubic:
+      return make_unique<CubicController>( mss, initial_window );
+    case TCPConfig::CongestionControl::BBR:
+      return make_unique<BBRController>( mss, initial_window );
+    case TCPConfig::CongestionControl::None:
+      break;
+  }
+  return nullptr;
+}
+
+namespace {
+
+// 慢启动时每个ACK最多把cwnd增加两个MSS（RFC 3465中的L）
+uint64_t slow_start_increase( uint64_t acked, uint64_t mss )
+{
+  return min( acked, 2 * mss );
+}
+
+// 没有带宽模型的算法按 cwnd / RTT 估算发送速率，慢启动时加倍以免pacing拖慢窗口增长
+uint64_t rate_from_cwnd( uint64_t cwnd, uint64_t rtt_ms, bool slow_start )
+{
+  if ( rtt_ms == 0 ) {
+    return 0;
+  }
+  const double gain = slow_start ? 2.0 : 1.2;
+  return static_cast<uint64_t>( gain * static_cast<double>( cwnd ) * 1000.0 / static_cast<double>( rtt_ms ) );
+}
+
+} // namespace
+
+// ------------------------------ Reno ------------------------------
+
+void RenoController::on_ack( const AckSample& sample )
+{
+  // 恢复期内不增长窗口
+  if ( sample.in_recovery ) {
+    return;
+  }
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += slow_start_increase( sample.acked, mss_ );
+  } else {
+    // 拥塞避免：每确认一个cwnd的数据，cwnd增加一个MSS
+    bytes_acked_ += sample.acked;
+    if ( bytes_acked_ >= cwnd_ ) {
+      bytes_acked_ -= cwnd_;
+      cwnd_ += mss_;
+    }
+  }
+  if ( sample.rtt_ms.has_value() ) {
+    pacing_rate_ = rate_from_cwnd( cwnd_, sample.rtt_ms.value(), cwnd_ < ssthresh_ );
+  }
+}
+
+void RenoController::on_loss( uint64_t now_ms, uint64_t in_flight )
+{
+  (void)now_ms;
+  ssthresh_ = max( in_flight / 2, 2 * mss_ );
+  cwnd_ = ssthresh_;
+  bytes_acked_ = 0;
+}
+
+void RenoController::on_rto( uint64_t now_ms, uint64_t in_flight )
+{
+  (void)now_ms;
+  ssthresh_ = max( in_flight / 2, 2 * mss_ );
+  cwnd_ = mss_;
+  bytes_acked_ = 0;
+}
+
+// ------------------------------ CUBIC ------------------------------
+
+void CubicController::on_ack( const AckSample& sample )
+{
+  if ( sample.rtt_ms.has_value() ) {
+    srtt_ms_ = srtt_ms_ ? ( 7 * srtt_ms_ + sample.rtt_ms.value() ) / 8 : sample.rtt_ms.value();
+  }
+  if ( sample.in_recovery ) {
+    return;
+  }
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += slow_start_increase( sample.acked, mss_ );
+    pacing_rate_ = rate_from_cwnd( cwnd_, srtt_ms_, true );
+    return;
+  }
+
+  const double mss = static_cast<double>( mss_ );
+  const double cwnd = static_cast<double>( cwnd_ ) / mss; // 单位：MSS
+  if ( !epoch_start_.has_value() ) {
+    // 新的拥塞避免阶段：从当前窗口出发，经过k_秒回到w_max_
+    epoch_start_ = sample.now_ms;
+    if ( w_max_ <= cwnd ) {
+      w_max_ = cwnd;
+      k_ = 0;
+    } else {
+      k_ = cbrt( ( w_max_ - cwnd ) / C );
+    }
+    w_est_ = cwnd;
+  }
+
+  // 预测一个RTT之后的目标窗口，每个RTT最多增长到1.5倍
+  const double t = static_cast<double>( sample.now_ms - epoch_start_.value() + srtt_ms_ ) / 1000.0;
+  double target = C * pow( t - k_, 3 ) + w_max_;
+  target = clamp( target, cwnd, 1.5 * cwnd );
+
+  // Reno友好区域：窗口不小于同样条件下Reno的窗口
+  const double acked = static_cast<double>( sample.acked ) / mss;
+  w_est_ += 3 * ( 1 - BETA ) / ( 1 + BETA ) * acked / cwnd;
+
+  const double grown = cwnd + ( target - cwnd ) / cwnd * acked;
+  cwnd_ = static_cast<uint64_t>( max( grown, w_est_ ) * mss );
+  pacing_rate_ = rate_from_cwnd( cwnd_, srtt_ms_, false );
+}
+
+void CubicController::reduce( uint64_t now_ms )
+{
+  (void)now_ms;
+  const double cwnd = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  // 快速收敛：窗口还没回到上次的w_max_就又丢包了，说明可用带宽变小了，让出更多带宽
+  w_max_ = cwnd < w_max_ ? cwnd * ( 1 + BETA ) / 2 : cwnd;
+  ssthresh_ = max( static_cast<uint64_t>( static_cast<double>( cwnd_ ) * BETA ), 2 * mss_ );
+  epoch_start_.reset();
+}
+
+void CubicController::on_loss( uint64_t now_ms, uint64_t in_flight )
+{
+  (void)in_flight;
+  reduce( now_ms );
+  cwnd_ = ssthresh_;
+}
+
+void CubicController::on_rto( uint64_t now_ms, uint64_t in_flight )
+{
+  (void)in_flight;
+  reduce( now_ms );
+  cwnd_ = mss_;
+}
+
+// ------------------------------ BBR ------------------------------
+
+namespace {
+// ProbeBW阶段的增益周期：先探测更高的带宽，再排空探测造成的排队，之后匀速发送
+constexpr array<double, 8> PROBE_BW_GAINS { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+} // namespace
+
+uint64_t BBRController::btl_bw() const
+{
+  return bw_samples_.empty() ? 0 : bw_samples_.front().second;
+}
+
+void BBRController::update_model( const AckSample& sample )
+{
+  // 被确认的segment是在上一轮结束之后发出的，说明又过了一轮
+  round_start_ = false;
+  if ( sample.prior_delivered >= next_round_delivered_ ) {
+    next_round_delivered_ = sample.delivered;
+    ++round_;
+    round_start_ = true;
+  }
+
+  // 最近BW_WINDOW_ROUNDS轮内发送速率的最大值（单调队列，队首最大）
+  if ( sample.delivery_rate.has_value() ) {
+    const uint64_t rate = sample.delivery_rate.value();
+    while ( !bw_samples_.empty() && bw_samples_.back().second <= rate ) {
+      bw_samples_.pop_back();
+    }
+    bw_samples_.emplace_back( round_, rate );
+  }
+  while ( !bw_samples_.empty() && bw_samples_.front().first + BW_WINDOW_ROUNDS <= round_ ) {
+    bw_samples_.pop_front();
+  }
+
+  if ( sample.rtt_ms.has_value() && ( !min_rtt_ms_.has_value() || sample.rtt_ms.value() < min_rtt_ms_.value() ) ) {
+    min_rtt_ms_ = sample.rtt_ms;
+  }
+}
+
+void BBRController::update_state( const AckSample& sample )
+{
+  const uint64_t bw = btl_bw();
+  switch ( state_ ) {
+    case State::Startup:
+      // 连续三轮带宽增长不到25%，认为瓶颈已经跑满
+      if ( round_start_ && bw > 0 ) {
+        if ( bw * 4 >= full_bw_ * 5 ) {
+          full_bw_ = bw;
+          full_bw_rounds_ = 0;
+        } else if ( ++full_bw_rounds_ >= 3 ) {
+          filled_pipe_ = true;
+          state_ = State::Drain;
+          pacing_gain_ = 1 / HIGH_GAIN;
+        }
+      }
+      break;
+
+    case State::Drain:
+      // Startup期间积累的排队排空之后进入ProbeBW
+      if ( sample.in_flight <= bw * min_rtt_ms_.value_or( 0 ) / 1000 ) {
+        state_ = State::ProbeBW;
+        cwnd_gain_ = 2;
+        cycle_index_ = 2;
+        cycle_start_ms_ = sample.now_ms;
+        pacing_gain_ = PROBE_BW_GAINS[cycle_index_];
+      }
+      break;
+
+    case State::ProbeBW:
+      // 每个最小RTT切换到下一个增益
+      if ( sample.now_ms - cycle_start_ms_ > min_rtt_ms_.value_or( 0 ) ) {
+        cycle_index_ = ( cycle_index_ + 1 ) % PROBE_BW_GAINS.size();
+        cycle_start_ms_ = sample.now_ms;
+        pacing_gain_ = PROBE_BW_GAINS[cycle_index_];
+      }
+      break;
+  }
+}
+
+void BBRController::on_ack( const AckSample& sample )
+{
+  update_model( sample );
+  update_state( sample );
+
+  const uint64_t bw = btl_bw();
+  if ( bw == 0 || !min_rtt_ms_.has_value() ) {
+    // 还没有模型，像慢启动一样增长
+    cwnd_ += sample.acked;
+    return;
+  }
+
+  const uint64_t bdp = bw * min_rtt_ms_.value() / 1000;
+  const auto target = max( static_cast<uint64_t>( cwnd_gain_ * static_cast<double>( bdp ) ), 4 * mss_ );
+  cwnd_ = filled_pipe_ ? min( cwnd_ + sample.acked, target ) : cwnd_ + sample.acked;
+  cwnd_ = max( cwnd_, 4 * mss_ );
+  pacing_rate_ = static_cast<uint64_t>( pacing_gain_ * static_cast<double>( bw ) );
+}
+
+void BBRController::on_loss( uint64_t now_ms, uint64_t in_flight )
+{
+  // 丢包不是BBR的拥塞信号，窗口和速率只由带宽和RTT的模型决定
+  (void)now_ms;
+  (void)in_flight;
+}
+
+void BBRController::on_rto( uint64_t now_ms, uint64_t in_flight )
+{
+  (void)now_ms;
+  (void)in_flight;
+  cwnd_ = 4 * mss_;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "tcp_config.hh"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+
+// 每次有新数据被确认时，TCPSender交给拥塞控制算法的信息
+struct AckSample
+{
+  uint64_t now_ms {};                       // 发送方的当前时间
+  uint64_t acked {};                        // 本次新确认（累计确认或SACK）的序列号个数
+  uint64_t in_flight {};                    // 确认之后仍在网络中的序列号个数（pipe）
+  std::optional<uint64_t> rtt_ms {};        // RTT样本：有时间戳时取自回显（重传过的数据也有），否则只取没有重传过的segment（Karn算法）
+  std::optional<uint64_t> delivery_rate {}; // 发送速率样本，单位：字节/秒
+  uint64_t delivered {};                    // 到目前为止累计被确认的序列号个数
+  uint64_t prior_delivered {};              // 被确认的segment发送时的delivered，用来划分"轮次"
+  bool in_recovery {};                      // 是否处于丢包恢复期
+};
+
+// 拥塞控制算法的接口：TCPSender在收到ACK、判定丢包、超时重传时通知它，
+// 它据此调整拥塞窗口cwnd和发送速率pacing_rate。
+class CongestionController
+{
+public:
+  // 初始窗口为initial_window个segment（RFC 6928）
+  CongestionController( uint64_t mss, uint64_t initial_window );
+  virtual ~CongestionController() = default;
+
+  virtual std::string name() const = 0;
+
+  // 有新数据被确认
+  virtual void on_ack( const AckSample& sample ) = 0;
+  // 根据SACK判定有数据丢失，每个恢复期只通知一次；in_flight为当时未确认的序列号个数
+  virtual void on_loss( uint64_t now_ms, uint64_t in_flight ) = 0;
+  // 重传计时器超时
+  virtual void on_rto( uint64_t now_ms, uint64_t in_flight ) = 0;
+
+  // PLPMTUD找到了更大的segment大小
+  void set_mss( uint64_t mss ) { mss_ = mss; }
+  // 握手时得知了对方的MSS，还没有发送数据，按新的MSS重新计算初始窗口
+  void set_initial_mss( uint64_t mss );
+
+  uint64_t cwnd() const { return cwnd_; }
+  // 发送速率，单位：字节/秒，0表示不限速
+  uint64_t pacing_rate() const { return pacing_rate_; }
+
+protected:
+  uint64_t mss_;
+  uint64_t initial_window_; // 初始窗口的segment个数
+  uint64_t cwnd_;
+  uint64_t pacing_rate_ {};
+};
+
+// 根据TCPConfig中的选择创建拥塞控制算法，None返回nullptr（只受接收方窗口限制）
+std::unique_ptr<CongestionController> make_congestion_controller( TCPConfig::CongestionControl algorithm,
+                                                                  uint64_t mss,
+                                                                  uint64_t initial_window );
+
+// Reno（RFC 5681）：慢启动 + 拥塞避免，丢包时窗口减半，超时后回到一个MSS
+class RenoController : public CongestionController
+{
+public:
+  using CongestionController::CongestionController;
+  std::string name() const override { return "Reno"; }
+  void on_ack( const AckSample& sample ) override;
+  void on_loss( uint64_t now_ms, uint64_t in_flight ) override;
+  void on_rto( uint64_t now_ms, uint64_t in_flight ) override;
+
+protected:
+  uint64_t ssthresh_ { UINT64_MAX };
+  uint64_t bytes_acked_ {}; // 拥塞避免阶段累计确认的字节数，满一个cwnd就把cwnd加一个MSS
+};
+
+// CUBIC（RFC 9438）：拥塞避免阶段的窗口是距离上次丢包时间的三次函数
+class CubicController : public CongestionController
+{
+public:
+  using CongestionController::CongestionController;
+  std::string name() const override { return "CUBIC"; }
+  void on_ack( const AckSample& sample ) override;
+  void on_loss( uint64_t now_ms, uint64_t in_flight ) override;
+  void on_rto( uint64_t now_ms, uint64_t in_flight ) override;
+
+private:
+  static constexpr double C = 0.4;
+  static constexpr double BETA = 0.7;
+
+  void reduce( uint64_t now_ms );
+
+  uint64_t ssthresh_ { UINT64_MAX };
+  double w_max_ {};                        // 上次丢包时的窗口，单位：MSS
+  double k_ {};                            // 窗口从减小后回到w_max_所需的时间，单位：秒
+  double w_est_ {};                        // 同样条件下Reno的窗口，保证不比Reno慢，单位：MSS
+  std::optional<uint64_t> epoch_start_ {}; // 本次拥塞避免阶段开始的时间
+  uint64_t srtt_ms_ {};
+};
+
+// 简化版BBR：测量瓶颈带宽（发送速率样本的窗口最大值）和最小RTT，
+// 按 增益 * 带宽 控制发送速率，按 增益 * BDP 控制cwnd，不把丢包当作拥塞信号。
+// 状态：Startup（指数增长直到带宽不再增加）-> Drain（排空队列）-> ProbeBW（周期性探测带宽）。
+class BBRController : public CongestionController
+{
+public:
+  using CongestionController::CongestionController;
+  std::string name() const override { return "BBR"; }
+  void on_ack( const AckSample& sample ) override;
+  void on_loss( uint64_t now_ms, uint64_t in_flight ) override;
+  void on_rto( uint64_t now_ms, uint64_t in_flight ) override;
+
+private:
+  enum class State : uint8_t
+  {
+    Startup,
+    Drain,
+    ProbeBW
+  };
+
+  static constexpr double HIGH_GAIN = 2.885; // 2/ln(2)
+  static constexpr uint64_t BW_WINDOW_ROUNDS = 10;
+
+  uint64_t btl_bw() const;
+  void update_model( const AckSample& sample );
+  void update_state( const AckSample& sample );
+
+  State state_ { State::Startup };
+  double pacing_gain_ { HIGH_GAIN };
+  double cwnd_gain_ { HIGH_GAIN };
+
+  std::deque<std::pair<uint64_t, uint64_t>> bw_samples_ {}; // (轮次, 发送速率)，用来求窗口最大值
+  std::optional<uint64_t> min_rtt_ms_ {};
+
+  uint64_t round_ {};                // 已经过去的轮次（每轮约一个RTT）
+  uint64_t next_round_delivered_ {}; // delivered达到这个值时进入下一轮
+  bool round_start_ {};
+
+  uint64_t full_bw_ {};        // Startup阶段见过的最大带宽
+  uint64_t full_bw_rounds_ {}; // 带宽没有明显增长的连续轮次
+  bool filled_pipe_ {};
+
+  uint64_t cycle_index_ {};
+  uint64_t cycle_start_ms_ {};
+};
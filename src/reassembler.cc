@@ -5,33 +5,77 @@ using namespace std;
 void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring )
 {
   // Your code here.
-  uint64_t start = max( _cur_index, first_index );
-  uint64_t end
-    = min( first_index + data.size(), min( _cur_index + output_.writer().available_capacity(), _eof_index ) );
   if ( is_last_substring ) {
     _eof_index = min( _eof_index, first_index + data.size() );
   }
 
-  for ( uint64_t i = start, j = start - first_index; i < end; i++, j++ ) {
-    auto& t = _stream[i % _capacity];
-    if ( t.second == true ) {
-      if ( t.first != data[j] )
-        throw __throw_runtime_error;
-    } else {
-      t = make_pair( data[j], true );
-      ++_unassembled_bytes_cnt;
+  // 快速路径：没有缓存的乱序数据，且data从_cur_index（或更早）开始，直接把它move进stream
+  if ( _buffer.empty() && first_index <= _cur_index ) {
+    const uint64_t end
+      = min( first_index + data.size(), min( _cur_index + output_.writer().available_capacity(), _eof_index ) );
+    if ( end > _cur_index ) {
+      data.resize( end - first_index );
+      data.erase( 0, _cur_index - first_index );
+      _cur_index = end;
+      output_.writer().push( move( data ) );
     }
+    if ( _cur_index == _eof_index )
+      output_.writer().close();
+    return;
   }
 
-  string str;
-  while ( _cur_index < _eof_index && _stream[_cur_index % _capacity].second == true ) {
-    str.push_back( _stream[_cur_index % _capacity].first );
-    _stream[_cur_index % _capacity] = { 0, false };
-    --_unassembled_bytes_cnt;
-    ++_cur_index;
+  // 慢速路径：把data裁剪到窗口[_cur_index, _cur_index + available_capacity)之内（也不能超过eof）
+  uint64_t start = max( _cur_index, first_index );
+  uint64_t end
+    = min( first_index + data.size(), min( _cur_index + output_.writer().available_capacity(), _eof_index ) );
+
+  if ( start < end ) {
+    // 先截掉尾部再截掉头部，都是原地操作
+    data.resize( end - first_index );
+    data.erase( 0, start - first_index );
+
+    // 找到第一个可能与[start, end)重叠或相邻的区间
+    auto it = _buffer.upper_bound( start );
+    if ( it != _buffer.begin() ) {
+      auto prev_it = prev( it );
+      const uint64_t prev_end = prev_it->first + prev_it->second.size();
+      if ( prev_end >= end ) {
+        // 完全被已有区间覆盖（重复数据），什么都不用做
+        start = end;
+      } else if ( prev_end >= start ) {
+        it = prev_it;
+      }
+    }
+
+    // 依次与重叠或相邻的区间合并，已有的字节优先
+    while ( start < end && it != _buffer.end() && it->first <= end ) {
+      string& chunk = it->second;
+      const uint64_t chunk_end = it->first + chunk.size();
+      _unassembled_bytes_cnt -= chunk.size();
+      if ( it->first <= start ) {
+        chunk.append( data, min( chunk_end - start, data.size() ) );
+        data = move( chunk );
+        start = it->first;
+      } else if ( chunk_end > end ) {
+        data.append( chunk, end - it->first );
+      }
+      end = max( end, chunk_end );
+      it = _buffer.erase( it );
+    }
+
+    if ( start < end ) {
+      _unassembled_bytes_cnt += data.size();
+      _buffer.emplace( start, move( data ) );
+    }
   }
 
-  output_.writer().push( str );
+  // 区间互不相邻，所以最多只有第一个区间能接在_cur_index后面，直接把它整个移动进stream
+  if ( !_buffer.empty() && _buffer.begin()->first == _cur_index ) {
+    auto node = _buffer.extract( _buffer.begin() );
+    _unassembled_bytes_cnt -= node.mapped().size();
+    _cur_index += node.mapped().size();
+    output_.writer().push( move( node.mapped() ) );
+  }
 
   if ( _cur_index == _eof_index )
     output_.writer().close();
@@ -42,3 +86,13 @@ uint64_t Reassembler::bytes_pending() const
   // Your code here.
   return _unassembled_bytes_cnt;
 }
+// 返回缓存中每个区间的[起始下标, 结束下标)，_buffer中的区间本身就互不重叠且不相邻
+vector<pair<uint64_t, uint64_t>> Reassembler::buffered_ranges() const
+{
+  vector<pair<uint64_t, uint64_t>> ranges;
+  ranges.reserve( _buffer.size() );
+  for ( const auto& [index, chunk] : _buffer ) {
+    ranges.emplace_back( index, index + chunk.size() );
+  }
+  return ranges;
+}
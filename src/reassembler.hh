@@ -3,6 +3,8 @@
 #include "byte_stream.hh"
 #include <limits>
 #include <map>
+#include <string>
+#include <utility>
 #include <vector>
 class Reassembler
 {
@@ -10,8 +12,6 @@ public:
   // Construct Reassembler to write into given ByteStream.
   explicit Reassembler( ByteStream&& output )
     : output_( std::move( output ) )
-    , _capacity( output.writer().available_capacity() )
-    , _stream( output.writer().available_capacity() )
     , _cur_index( 0 )
     , _eof_index( std::numeric_limits<uint64_t>::max() )
     , _unassembled_bytes_cnt( 0 )
@@ -41,6 +41,10 @@ public:
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
 
+  // The [first, last) stream indices of the bytes stored in the Reassembler, in increasing order.
+  // The ranges are disjoint and separated by holes that have not arrived yet.
+  std::vector<std::pair<uint64_t, uint64_t>> buffered_ranges() const;
+
   // Access output stream reader
   Reader& reader() { return output_.reader(); }
   const Reader& reader() const { return output_.reader(); }
@@ -48,12 +52,17 @@ public:
   // Access output stream writer, but const-only (can't write from outside)
   const Writer& writer() const { return output_.writer(); }
 
+  // Raise the output stream's capacity, which also widens the window of bytes the Reassembler accepts
+  void grow_capacity( uint64_t capacity ) { output_.grow( capacity ); }
+
 private:
   ByteStream output_; // the Reassembler writes to this ByteStream
 
-  size_t _capacity;                           //!< The maximum number of bytes
-  std::vector<std::pair<char, bool>> _stream; //!< The current part of the reassembled byte stream
-  size_t _cur_index;                          //!< The index of the first byte of the reassembled byte stream
-  size_t _eof_index;                          //!< The index of the last byte of the entire stream
-  size_t _unassembled_bytes_cnt;              //!< The number of bytes that have not yet been reassembled
+  //! Bytes that arrived out of order, keyed by the stream index of their first byte. The intervals are
+  //! disjoint and never adjacent (touching or overlapping pieces are merged on insert), and all of them
+  //! lie within [_cur_index, _cur_index + available capacity).
+  std::map<uint64_t, std::string> _buffer {};
+  size_t _cur_index;             //!< The index of the first byte of the reassembled byte stream
+  size_t _eof_index;             //!< The index of the last byte of the entire stream
+  size_t _unassembled_bytes_cnt; //!< The number of bytes that have not yet been reassembled
 };
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 using namespace std;
 
 void TCPReceiver::receive( TCPSenderMessage message )
@@ -9,6 +11,7 @@ void TCPReceiver::receive( TCPSenderMessage message )
     reassembler_.reader().set_error();
     return;
   }
+  const bool opening = !open;
   if ( open == false ) {
     if ( !message.SYN )
       return;
@@ -21,9 +24,88 @@ void TCPReceiver::receive( TCPSenderMessage message )
   uint64_t checkpoint = reassembler_.writer().bytes_pushed();
   uint64_t ab_seqno = seqno.unwrap( isn, checkpoint );
   uint64_t index = message.SYN ? ab_seqno : ab_seqno - 1;
+  // PAWS（RFC 7323）：时间戳比已经接受过的更旧，说明这是很久以前的报文，它的seqno可能已经回绕，丢弃
+  if ( message.timestamp.has_value() && _ts_recent.has_value()
+       && static_cast<int32_t>( message.timestamp.value() - _ts_recent.value() ) < 0 )
+    return;
+  // 报文是否可以接受（RFC 9293 3.10.7.4）：至少有一部分落在窗口[RCV.NXT, RCV.NXT + RCV.WND)之内，
+  // 不占序列号的报文要求seqno在窗口之内（窗口为0时等于RCV.NXT）；建立连接的SYN总是可以接受
+  const uint64_t rcv_nxt = checkpoint + 1 + ( reassembler_.writer().is_closed() ? 1 : 0 );
+  const uint64_t seg_len = message.sequence_length();
+  const bool acceptable
+    = opening
+      || ( seg_len == 0 ? ab_seqno == rcv_nxt || ( ab_seqno > rcv_nxt && ab_seqno < rcv_nxt + window_size() )
+                        : window_size() > 0 && ab_seqno < rcv_nxt + window_size() && ab_seqno + seg_len > rcv_nxt );
+  // 只接受通告过的窗口之内的数据：ByteStream的容量可能比窗口字段能表示的更大（比如没有协商窗口扩大选项时），
+  // 超出窗口的部分（和它后面的FIN）丢掉，否则窗口算不出来，对方还会继续发送
+  const uint64_t window_end = checkpoint + window_size();
+  const uint64_t accepted = index < window_end ? window_end - index : 0;
+  if ( message.payload.size() > accepted ) {
+    message.payload.resize( accepted );
+    message.FIN = false;
+  }
+  // 只有可以接受的报文才更新TS.Recent（RFC 7323 4.3），并且只记录不超过上次发出的ackno的报文的时间戳，
+  // 这样延迟的ACK和乱序时回显的是较早的时间，RTT样本偏大而不是偏小
+  if ( message.timestamp.has_value() && acceptable && ab_seqno <= _last_ack_sent.value_or( checkpoint + 1 ) )
+    _ts_recent = message.timestamp;
+  if ( !message.payload.empty() )
+    _last_index = index;
   reassembler_.insert( index, message.payload, message.FIN );
 }
 
+void TCPReceiver::ack_sent()
+{
+  if ( open )
+    _last_ack_sent = reassembler_.writer().bytes_pushed() + 1 + ( reassembler_.writer().is_closed() ? 1 : 0 );
+}
+
+void TCPReceiver::set_window_scale( uint8_t shift )
+{
+  _max_window = (size_t)UINT16_MAX << shift;
+  _capacity = min( _stream_capacity, _max_window );
+}
+
+void TCPReceiver::autotune( uint64_t now_ms, optional<uint64_t> rtt_ms )
+{
+  if ( !open || _stream_capacity >= min( _max_capacity, _max_window ) )
+    return;
+
+  // 估计RTT：时间戳的样本取平滑值；没有时间戳时，从通告一个窗口到这个窗口的数据全部到达至少要一个RTT，
+  // 这样的样本只会偏大，所以取最小值（与Linux的tcp_rcv_rtt_measure相同）
+  const uint64_t pushed = reassembler_.writer().bytes_pushed();
+  if ( rtt_ms.has_value() ) {
+    const uint64_t sample = max( rtt_ms.value(), uint64_t { 1 } );
+    _rcv_rtt = _rcv_rtt ? ( 7 * _rcv_rtt + sample ) / 8 : sample;
+  } else if ( !_rtt_edge.has_value() || pushed >= _rtt_edge.value() ) {
+    if ( _rtt_edge.has_value() ) {
+      const uint64_t sample = max( now_ms - _rtt_edge_time, uint64_t { 1 } );
+      _rcv_rtt = _rcv_rtt ? min( _rcv_rtt, sample ) : sample;
+    }
+    _rtt_edge = pushed + send().window_size;
+    _rtt_edge_time = now_ms;
+  }
+  if ( _rcv_rtt == 0 || now_ms - _space_time < _rcv_rtt )
+    return;
+
+  // 过去一个RTT内应用读走的数据超过了窗口的一半：对方可能受窗口限制，
+  // 把容量提高到它的两倍，给对方的拥塞窗口留出继续增长的余地
+  const uint64_t popped = reassembler_.reader().bytes_popped();
+  const uint64_t copied = popped - _space_popped;
+  if ( 2 * copied > _stream_capacity ) {
+    reassembler_.grow_capacity( min( 2 * copied, min( _max_capacity, _max_window ) ) );
+    _stream_capacity = reassembler_.writer().capacity();
+    _capacity = min( _stream_capacity, _max_window );
+  }
+  _space_time = now_ms;
+  _space_popped = popped;
+}
+
+uint64_t TCPReceiver::window_size() const
+{
+  const uint64_t buffered = reassembler_.reader().bytes_buffered();
+  return _capacity > buffered ? _capacity - buffered : 0;
+}
+
 TCPReceiverMessage TCPReceiver::send() const
 {
   // Your code here.
@@ -35,6 +117,24 @@ TCPReceiverMessage TCPReceiver::send() const
     message.ackno = Wrap32::wrap( ab_seqno, isn );
   }
   message.RST = reassembler_.reader().has_error();
-  message.window_size = _capacity - reassembler_.reader().bytes_buffered();
+  message.window_size = static_cast<uint32_t>( window_size() );
+  message.timestamp_echo = _ts_recent;
+
+  // SACK：第一个block是最近收到的报文所在的区间，其余的按从小到大的顺序填满
+  if ( open ) {
+    const auto ranges = reassembler_.buffered_ranges();
+    auto to_block = [&]( const pair<uint64_t, uint64_t>& range ) {
+      return SACKBlock { Wrap32::wrap( range.first + 1, isn ), Wrap32::wrap( range.second + 1, isn ) };
+    };
+    auto latest = find_if( ranges.begin(), ranges.end(), [&]( const auto& range ) {
+      return range.first <= _last_index && _last_index < range.second;
+    } );
+    if ( latest != ranges.end() )
+      message.sack.push_back( to_block( *latest ) );
+    for ( auto it = ranges.begin(); it != ranges.end() && message.sack.size() < message.MAX_SACK_BLOCKS; ++it ) {
+      if ( it != latest )
+        message.sack.push_back( to_block( *it ) );
+    }
+  }
   return message;
 }
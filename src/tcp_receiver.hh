@@ -4,6 +4,8 @@
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
+#include <optional>
+
 class TCPReceiver
 {
 public:
@@ -12,9 +14,26 @@ public:
     : reassembler_( std::move( reassembler ) )
     , isn( -1 )
     , open( false )
-    , _capacity( std::min( (size_t)reassembler_.writer().available_capacity(), (size_t)UINT16_MAX ) )
+    , _stream_capacity( reassembler_.writer().available_capacity() )
+    , _capacity( std::min( _stream_capacity, _max_window ) )
+    , _last_index( 0 )
   {}
 
+  // 双方都同意使用窗口扩大选项（RFC 7323）之后，通告的窗口可以达到 UINT16_MAX << shift
+  void set_window_scale( uint8_t shift );
+
+  // 接收窗口自动调整：ByteStream的容量最多可以增长到max_capacity（不大于当前容量时不调整）
+  void set_max_capacity( size_t max_capacity ) { _max_capacity = max_capacity; }
+
+  // 接收窗口自动调整（类似Linux的Dynamic Right-Sizing）：每个RTT统计应用读走的字节数，
+  // 把ByteStream的容量提高到它的两倍，这样窗口只在应用读得快、对方被窗口限制时增长。
+  // now_ms为当前时间；rtt_ms为根据时间戳回显得到的RTT样本，没有时用窗口右边界被填满所用的时间估计RTT
+  void autotune( uint64_t now_ms, std::optional<uint64_t> rtt_ms );
+
+  // 记录send()的ackno确实被发出去了（RFC 7323的Last.ACK.sent）。延迟ACK时，收到的数据不一定马上被确认，
+  // 只有不超过上次发出的ackno的报文才更新要回显的时间戳；从不调用时认为send()的每个ackno都发出去了
+  void ack_sent();
+
   /*
    * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
    * at the correct stream index.
@@ -31,8 +50,22 @@ public:
   const Writer& writer() const { return reassembler_.writer(); }
 
 private:
+  // 通告的窗口：_capacity减去ByteStream中还没被读走的字节
+  uint64_t window_size() const;
+
   Reassembler reassembler_;
-  Wrap32 isn;       // zero_point
-  bool open;        // ISN
-  size_t _capacity; // 容量，最大为UINT16_MAX
+  Wrap32 isn;                                // zero_point
+  bool open;                                 // ISN
+  size_t _stream_capacity;                   // ByteStream的容量
+  size_t _max_window { UINT16_MAX };         // 窗口字段能表示的最大窗口（使用窗口扩大选项时为UINT16_MAX << shift）
+  size_t _capacity;                          // 通告的窗口的上限，不超过_stream_capacity和_max_window
+  uint64_t _last_index;                      // 最近收到的带数据的报文的stream index，SACK的第一个block要包含它
+  std::optional<uint32_t> _ts_recent {};     // 要回显给对方的时间戳（RFC 7323的TS.Recent），也用于PAWS
+  std::optional<uint64_t> _last_ack_sent {}; // 最近一次发出的ACK的absolute ackno（RFC 7323的Last.ACK.sent）
+  size_t _max_capacity {};                   // 自动调整时ByteStream容量的上限
+  uint64_t _rcv_rtt {};                      // 接收方估计的RTT，0表示还没有估计
+  std::optional<uint64_t> _rtt_edge {};      // 没有时间戳时测RTT：测量开始时窗口的右边界（stream index）
+  uint64_t _rtt_edge_time {};                // 测量开始的时间
+  uint64_t _space_time {};                   // 本轮统计开始的时间
+  uint64_t _space_popped {};                 // 本轮统计开始时应用已经读走的字节数
 };
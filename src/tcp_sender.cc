@@ -1,8 +1,68 @@
 #include "tcp_sender.hh"
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <stdexcept>
+
 using namespace std;
 
+TCPSender::TCPSender( ByteStream&& input, const TCPConfig& cfg )
+  : TCPSender( std::move( input ), cfg.isn, cfg.rt_timeout )
+{
+  // PLPMTUD从保守的MAX_PAYLOAD_SIZE开始，向上探测到cfg.mss；不探测时直接使用cfg.mss
+  _mtu_probing = cfg.mtu_probing;
+  _mss = _mtu_probing ? min( cfg.mss, TCPConfig::MAX_PAYLOAD_SIZE ) : cfg.mss;
+  _mtu_probe_high = cfg.mss;
+  _cc = make_congestion_controller( cfg.congestion_control, _mss, cfg.initial_window );
+  if ( cfg.min_rto > cfg.max_rto ) {
+    throw invalid_argument( "TCPConfig: min_rto is larger than max_rto" );
+  }
+  _rtt = RTTEstimator( cfg.rt_timeout, cfg.min_rto, cfg.max_rto );
+  _adaptive_rto = cfg.adaptive_rto;
+  // 自适应RTO时，第一个segment的RTO也要在[min_rto, max_rto]之内
+  if ( _adaptive_rto ) {
+    _timer.set_time_out( _rtt.rto() );
+  }
+  _fast_retransmit = cfg.fast_retransmit;
+  _rack_tlp = cfg.rack_tlp;
+  _pacing = cfg.pacing;
+  _fixed_pacing_rate = cfg.pacing_rate;
+  _pacing_burst = cfg.pacing_burst;
+  _persist = cfg.persist_timer;
+  _nagle = cfg.nagle;
+  _cork = cfg.cork;
+  _cork_timer.set_time_out( cfg.cork_timeout );
+  _send_capacity = input_.capacity();
+  _max_send_capacity = cfg.max_send_capacity;
+  // 令牌桶一开始是满的
+  _pacing_credit = static_cast<int64_t>( _pacing_burst * 1000 );
+}
+
+void RTTEstimator::add_sample( uint64_t rtt_ms )
+{
+  _min_rtt = _has_sample ? min( _min_rtt, rtt_ms ) : rtt_ms;
+  if ( !_has_sample ) {
+    // 第一个样本：SRTT = R，RTTVAR = R / 2
+    _srtt8 = rtt_ms * 8;
+    _rttvar4 = rtt_ms * 2;
+    _has_sample = true;
+    return;
+  }
+  // RTTVAR = 3/4 * RTTVAR + 1/4 * |SRTT - R|，要用更新之前的SRTT
+  const uint64_t old_srtt = srtt();
+  const uint64_t err = old_srtt > rtt_ms ? old_srtt - rtt_ms : rtt_ms - old_srtt;
+  _rttvar4 = _rttvar4 - _rttvar4 / 4 + err;
+  // SRTT = 7/8 * SRTT + 1/8 * R
+  _srtt8 = _srtt8 - _srtt8 / 8 + rtt_ms;
+}
+
+uint64_t RTTEstimator::rto() const
+{
+  // RTO = SRTT + max(G, 4 * RTTVAR)，时钟粒度G为tick的1毫秒；还没有样本时用初始RTO，同样限制在[min_rto, max_rto]
+  const uint64_t rto = _has_sample ? srtt() + max( _rttvar4, uint64_t { 1 } ) : _initial_rto;
+  return clamp( rto, _min_rto, _max_rto );
+}
+
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
   // 返回未被确认的字节大小
@@ -15,57 +75,282 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return _consecutive_retransmissions;
 }
 
+uint64_t TCPSender::congestion_window() const
+{
+  return _cc ? _cc->cwnd() : UINT64_MAX;
+}
+
+uint64_t TCPSender::pacing_rate() const
+{
+  if ( _fixed_pacing_rate > 0 )
+    return _fixed_pacing_rate;
+  return _cc ? _cc->pacing_rate() : 0;
+}
+
+bool TCPSender::paced() const
+{
+  // 还不知道速率（比如拥塞控制算法还没有RTT样本）时不限速
+  return _pacing && pacing_rate() > 0;
+}
+
+uint64_t TCPSender::smoothed_rtt() const
+{
+  return _rtt.srtt();
+}
+
+uint64_t TCPSender::rtt_variation() const
+{
+  return _rtt.rttvar();
+}
+
+uint64_t TCPSender::current_RTO_ms() const
+{
+  return _adaptive_rto ? _rtt.rto() : initial_RTO_ms_;
+}
+
+uint64_t TCPSender::mss() const
+{
+  return _mss;
+}
+
+void TCPSender::set_peer_mss( uint64_t mss )
+{
+  mss = max( mss, uint64_t { 1 } );
+  _mss = min( _mss, mss );
+  _mtu_probe_high = min( _mtu_probe_high, mss );
+  if ( !_cc )
+    return;
+  // 初始窗口以segment为单位，在发送数据之前知道了真正的MSS就按它计算
+  if ( _next_seqno <= 1 )
+    _cc->set_initial_mss( _mss );
+  else
+    _cc->set_mss( _mss );
+}
+
+void TCPSender::set_options_length( uint64_t len )
+{
+  _options_len = len;
+}
+
+uint64_t TCPSender::payload_limit() const
+{
+  // 选项占用的字节要从MSS中扣除（RFC 9293 3.7.1、RFC 6691），但每个segment至少能带一个字节
+  return _mss > _options_len ? _mss - _options_len : 1;
+}
+
+uint64_t TCPSender::mtu_probe_size() const
+{
+  // 同一时间只有一个探测报文；恢复期内的丢包无法区分原因，不探测
+  if ( !_mtu_probing || _mtu_probe_seqno.has_value() || _in_recovery
+       || _mtu_probe_high < _mss + TCPConfig::MIN_PROBE_STEP )
+    return 0;
+  // 在已经确认可行的大小和还没有被排除的最大值之间二分查找
+  return ( _mss + _mtu_probe_high + 1 ) / 2;
+}
+
+uint64_t TCPSender::send_allowance( uint64_t windows_size ) const
+{
+  if ( _sequence_numbers_in_flight >= windows_size )
+    return 0;
+  // 令牌用完了，等tick补充
+  if ( paced() && _pacing_credit <= 0 )
+    return 0;
+  uint64_t allowance = windows_size - _sequence_numbers_in_flight;
+  if ( _cc ) {
+    const uint64_t cwnd = _cc->cwnd();
+    const uint64_t cwnd_allowance = cwnd > pipe() ? cwnd - pipe() : 0;
+    // 拥塞窗口剩余不足一个segment时先等待，避免切出很小的segment（没有数据在途时除外）
+    const uint64_t wanted = min( payload_limit(), unsent_bytes() );
+    if ( cwnd_allowance < wanted && pipe() > 0 )
+      return 0;
+    allowance = min( allowance, max( cwnd_allowance, uint64_t { 1 } ) );
+  }
+  return allowance;
+}
+
+uint64_t TCPSender::usable_window() const
+{
+  return _persist ? _windows_size : max( _windows_size, (uint32_t)1 );
+}
+
+void TCPSender::update_persist()
+{
+  // 窗口为零并且没有在途的数据时，不会再有ACK带来窗口更新，只能靠探测
+  const bool stalled = _persist && SYN && _windows_size == 0 && _sequence_numbers_in_flight == 0
+                       && ( unsent_bytes() > 0 || ( input_.writer().is_closed() && !FIN ) );
+  if ( !stalled ) {
+    _persist_timer.stop();
+    return;
+  }
+  // 已经在计时的话保留退避之后的间隔，探测的回复仍是零窗口时也不重新计时
+  if ( !_persist_timer.is_open() ) {
+    _persist_timer.set_time_out( current_RTO_ms() );
+    _persist_timer.restart();
+  }
+}
+
 void TCPSender::push( const TransmitFunction& transmit )
 {
+  // 先重传记分板上判定为丢失的segment，它们本来就在窗口之内
+  retransmit_lost( transmit );
+
   // 首先判断窗口大小
-  uint32_t windows_size = max( _windows_size, (uint32_t)1 );
-  // 接收方有足够大小的窗口才可以开始发送
-  while ( _sequence_numbers_in_flight < windows_size ) {
-    TCPSenderMessage msg;
-    // SYN = false 说明还没有建立连接，先建立连接
-    if ( !SYN ) {
-      msg.SYN = true;
-      SYN = true;
-    }
-    // 对于 payload_size的大小：
-    // 首先不能超过MAX_PAYLOAD_SIZE
-    // 其次接收方窗口必须有足够大小放下，用windows_size减去未被确认的字节数再减去SYN所占用的
-    // 最后是不能超过input_中所存储的有效字节
-    auto payload_size
-      = min( TCPConfig::MAX_PAYLOAD_SIZE,
-             min( windows_size - _sequence_numbers_in_flight - msg.SYN, input_.writer().bytes_pushed() ) );
-    string payload;
-    // 读取payload_size个字节，放入payload中
-    for ( uint64_t i = 0; i < payload_size; ++i ) {
-      payload += input_.reader().peek();
-      input_.reader().pop( 1 );
-    }
-    msg.payload = move( payload );
-    // 如果已经读取完input_中的数据，说明所有要发送的数据都已经发送，那么就将msg的FIN置为true
-    // 需要注意的是要判断FIN是否能放下，因为之前选择payload的字段时没有考虑FIN，意味着如果SYN和payload就占满了windows_size，那么就不能传输FIN了
-    if ( !FIN && input_.reader().is_finished()
-         && _sequence_numbers_in_flight + msg.sequence_length() < windows_size ) {
-      msg.FIN = true;
-      FIN = true;
-    }
-    int msg_len = msg.sequence_length();
-    if ( msg.sequence_length() == 0 )
-      break;
-    // 从absolute_seqno转换到seqno
-    msg.seqno = Wrap32::wrap( _next_seqno, isn_ );
-    msg.RST = input_.has_error();
-    transmit( msg );
-    // 发送数据后，如果没有打开计时器就打开计时器
-    if ( !_timer.is_open() ) {
-      _timer.restart();
+  const uint64_t windows_size = usable_window();
+  // 接收方窗口（和拥塞窗口）有空间才可以开始发送
+  uint64_t allowance = 0;
+  bool sent = false;
+  while ( ( allowance = send_allowance( windows_size ) ) > 0 && send_segment( allowance, transmit ) )
+    sent = true;
+  // 发送了新数据，重新设置尾部丢包探测的时间
+  if ( sent )
+    arm_probe();
+  update_persist();
+  // cork留着数据时开始计时，到期后不再等待；已经在计时的话不重新计时
+  if ( !_cork || !hold_small_segment( unsent_bytes() ) )
+    _cork_timer.stop();
+  else if ( !_cork_timer.is_open() )
+    _cork_timer.restart();
+}
+
+void TCPSender::flush( const TransmitFunction& transmit )
+{
+  _flush_upto = input_.writer().bytes_pushed();
+  push( transmit );
+}
+
+bool TCPSender::hold_small_segment( uint64_t unsent ) const
+{
+  // 够一个MSS的数据、最后带FIN的数据和flush之前写入的数据都立即发送
+  if ( !SYN || unsent == 0 || unsent >= payload_limit() || input_.writer().is_closed() )
+    return false;
+  if ( input_.writer().bytes_pushed() - unsent < _flush_upto )
+    return false;
+  // Nagle（RFC 896、RFC 1122 4.2.3.4）：只要还有数据没被确认，就等ACK回来再把积攒的数据一起发送
+  return _cork || ( _nagle && _sequence_numbers_in_flight > 0 );
+}
+
+void TCPSender::retransmit_lost( const TransmitFunction& transmit )
+{
+  for ( auto it = _outstanding_seg.begin(); _lost_seqnos > 0 && it != _outstanding_seg.end(); ++it ) {
+    if ( it->lost && !it->retransmitted ) {
+      _lost_seqnos -= it->sequence_length();
+      retransmit( *it, transmit );
     }
-    // 将报文暂存在队列中，以便超时重传
-    _outstanding_seg.push( { _next_seqno, move( msg ) } );
+  }
+}
 
-    // 更新未接收到的字节数和下一个报文的seqno
-    _sequence_numbers_in_flight += msg_len;
-    _next_seqno += msg_len;
+bool TCPSender::send_segment( uint64_t allowance, const TransmitFunction& transmit )
+{
+  OutstandingSegment seg { .seqno = _next_seqno,
+                           .payload_size = 0,
+                           .SYN = false,
+                           .FIN = false,
+                           .sent_ms = _now_ms,
+                           .delivered = _delivered,
+                           .delivered_ms = _delivered_ms };
+  const uint64_t unsent = unsent_bytes();
+  if ( hold_small_segment( unsent ) )
+    return false;
+  // SYN = false 说明还没有建立连接，先建立连接
+  if ( !SYN ) {
+    seg.SYN = true;
+    SYN = true;
+  }
+  // PLPMTUD：有足够的数据并且窗口允许时，发送一个更大的segment探测路径（探测的大小同样包括选项）
+  uint64_t max_payload = payload_limit();
+  const uint64_t probe = seg.SYN ? 0 : mtu_probe_size();
+  const uint64_t probe_payload = probe > _options_len ? probe - _options_len : 0;
+  if ( probe_payload > max_payload && unsent >= probe_payload && allowance >= probe_payload )
+    max_payload = probe_payload;
+  // 对于 payload_size的大小：
+  // 首先不能超过MSS减去选项的长度（或者探测的大小）
+  // 其次窗口必须有足够大小放下，用窗口剩余的大小allowance再减去SYN所占用的
+  // 最后是不能超过input_中还没有发送的字节
+  seg.payload_size = min( max_payload, min( allowance - seg.SYN, unsent ) );
+  // 如果input_已经关闭并且数据都要发送出去了，那么就将FIN置为true
+  // 需要注意的是要判断FIN是否能放下，因为之前选择payload的字段时没有考虑FIN，意味着如果SYN和payload就占满了windows_size，那么就不能传输FIN了
+  if ( !FIN && input_.writer().is_closed() && seg.payload_size == unsent && seg.sequence_length() < allowance ) {
+    seg.FIN = true;
+    FIN = true;
+  }
+  const uint64_t msg_len = seg.sequence_length();
+  if ( msg_len == 0 )
+    return false;
+  transmit( make_message( seg ) );
+  // 发送数据后，如果没有打开计时器就打开计时器
+  if ( !_timer.is_open() ) {
+    _timer.restart();
+  }
+  // 记录在队列中，以便超时重传（payload仍在input_中）
+  _outstanding_seg.push_back( seg );
+  if ( max_payload > payload_limit() ) {
+    _mtu_probe_seqno = seg.seqno;
+    _mtu_probe_size = seg.payload_size + _options_len;
   }
+
+  // 令牌可以透支一个segment，这样突发最多是令牌桶的容量加一个segment
+  if ( paced() )
+    _pacing_credit -= static_cast<int64_t>( msg_len ) * 1000;
+
+  // 更新未接收到的字节数和下一个报文的seqno
+  _sequence_numbers_in_flight += msg_len;
+  _next_seqno += msg_len;
+  grow_send_buffer();
+  return true;
+}
+
+void TCPSender::grow_send_buffer()
+{
+  if ( _max_send_capacity <= input_.capacity() )
+    return;
+  // 已经发送、还没有被确认的字节不占用应用的_send_capacity（容量只增不减）
+  const uint64_t in_flight = input_.reader().bytes_buffered() - unsent_bytes();
+  input_.grow( min( _send_capacity + in_flight, _max_send_capacity ) );
+}
+
+uint64_t TCPSender::unsent_bytes() const
+{
+  if ( FIN )
+    return 0;
+  // SYN占用了一个序列号，之后的seqno减一就是stream index
+  const uint64_t next_index = _next_seqno - ( SYN ? 1 : 0 );
+  return input_.writer().bytes_pushed() - next_index;
+}
+
+TCPSenderMessage TCPSender::make_message( const OutstandingSegment& seg, uint64_t offset, uint64_t max_len ) const
+{
+  const uint64_t len = min( max_len, seg.payload_size - offset );
+  TCPSenderMessage msg;
+  msg.seqno = Wrap32::wrap( seg.seqno + ( offset > 0 ? seg.SYN + offset : 0 ), isn_ );
+  msg.SYN = seg.SYN && offset == 0;
+  msg.FIN = seg.FIN && offset + len == seg.payload_size;
+  msg.RST = input_.has_error();
+  // 每次（重新）发送都带上当前时间，对方回显之后，重传的segment也能得到RTT样本
+  msg.timestamp = timestamp();
+  // 一次从input_中切出整个payload
+  msg.payload = input_.reader().slice( seg.stream_index() - input_.reader().bytes_popped() + offset, len );
+  return msg;
+}
+
+void TCPSender::retransmit( OutstandingSegment& seg, const TransmitFunction& transmit )
+{
+  // PLPMTUD：探测报文需要重传，说明路径可能容不下这个大小，丢失MAX_PROBES次就不再尝试这个大小
+  if ( is_mtu_probe( seg ) ) {
+    _mtu_probe_seqno.reset();
+    if ( ++_mtu_probe_failures >= TCPConfig::MAX_PROBES ) {
+      _mtu_probe_high = _mtu_probe_size - 1;
+      _mtu_probe_failures = 0;
+    }
+  }
+  // 放不进一个segment的（丢失的探测报文，或者现在要带更多的选项）拆成几个重传
+  const uint64_t limit = payload_limit();
+  uint64_t offset = 0;
+  do {
+    transmit( make_message( seg, offset, limit ) );
+    offset += limit;
+  } while ( offset < seg.payload_size );
+  seg.retransmitted = true;
+  seg.sent_ms = _now_ms;
 }
 
 TCPSenderMessage TCPSender::make_empty_message() const
@@ -74,6 +359,7 @@ TCPSenderMessage TCPSender::make_empty_message() const
   TCPSenderMessage msg;
   msg.RST = input_.has_error();
   msg.seqno = Wrap32::wrap( _next_seqno, isn_ );
+  msg.timestamp = timestamp();
   return msg;
 }
 
@@ -84,6 +370,7 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
     if ( msg.RST )
       input_.set_error();
     _windows_size = msg.window_size;
+    update_persist();
     return;
   }
   // 接收到的报文有RST，那就置错
@@ -95,39 +382,369 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
   if ( abs_ackno > _next_seqno )
     return;
   bool receive = false;
+  uint64_t cum_acked = 0;
+  DeliverySample sample;
   // 将ackno之前的所有未确认的报文确认，并从队列中删除
   while ( !_outstanding_seg.empty() ) {
-    auto& [seqno, outstanding_msg] = _outstanding_seg.front();
-    if ( seqno + outstanding_msg.sequence_length() - 1 < abs_ackno ) {
+    auto& seg = _outstanding_seg.front();
+    if ( seg.seqno + seg.sequence_length() - 1 < abs_ackno ) {
       receive = true;
-      _sequence_numbers_in_flight -= outstanding_msg.sequence_length();
-      _outstanding_seg.pop();
+      cum_acked += seg.sequence_length();
+      _sequence_numbers_in_flight -= seg.sequence_length();
+      if ( seg.sacked )
+        _sacked_seqnos -= seg.sequence_length();
+      else
+        mark_delivered( seg, sample );
+      if ( seg.lost && !seg.retransmitted )
+        _lost_seqnos -= seg.sequence_length();
+      // 确认之后payload不再需要，从input_中pop掉
+      input_.reader().pop( seg.payload_size );
+      _outstanding_seg.pop_front();
     } else
       break;
   }
+  // 接收方回显了我们的时间戳（RFC 7323）：现在减去回显的时间就是RTT，不管确认的是不是重传的数据。
+  // 只在ackno前进时采样，乱序时接收方回显的是较早的时间戳
+  if ( receive && msg.timestamp_echo.has_value() )
+    sample.echo_rtt = static_cast<uint32_t>( timestamp() - msg.timestamp_echo.value() );
+  // 恢复期开始时已经发出的数据都被确认了，恢复期结束
+  if ( _in_recovery && abs_ackno >= _recovery_point )
+    _in_recovery = false;
+  // 根据SACK判定出新的丢包，进入恢复期，每个恢复期只让拥塞控制算法减小一次窗口
+  if ( !msg.sack.empty() ) {
+    bool newly_lost = update_scoreboard( msg.sack, sample );
+    if ( _rack_tlp )
+      newly_lost |= rack_detect_loss();
+    if ( newly_lost && !_in_recovery )
+      enter_recovery( false );
+  } else if ( _fast_retransmit ) {
+    // 接收方没有报告SACK，只能根据重复ACK判断丢包
+    update_newreno( abs_ackno, cum_acked, msg.window_size );
+  }
+  report_ack( sample );
   // 如果有报文确认，那么就将连续重传次数清零，并且重置计时器
   if ( receive ) {
     _consecutive_retransmissions = 0;
-    _timer.set_time_out( initial_RTO_ms_ );
+    _timer.set_time_out( current_RTO_ms() );
     _timer.restart();
+    // 探测报文（或者它之前的数据）已被确认，可以再次探测
+    _probe_pending = false;
+    arm_probe();
   }
   // 如果所有报文都被确认，那么计时器中止
   if ( _sequence_numbers_in_flight == 0 ) {
     _timer.stop();
+    _reorder_timer.stop();
   }
   _windows_size = msg.window_size;
+  // 窗口打开了就停止坚持计时器
+  update_persist();
 }
 
 void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
 {
+  _now_ms += ms_since_last_tick;
   _timer.tick( ms_since_last_tick );
-  // 超时重传，并将RTO乘2
+
+  // 尾部丢包探测（TLP）：在PTO内没有收到ACK，发送一个探测报文，让接收方用SACK告诉我们丢了什么。
+  // PTO最多等于RTO，两者同时到期时先发探测，它会重启重传计时器
+  _probe_timer.tick( ms_since_last_tick );
+  if ( _probe_timer.check_time_out() )
+    send_probe( transmit );
+
+  // 超时重传（重传第一个没有被SACK的segment），并将RTO乘2
   if ( _timer.check_time_out() ) {
-    transmit( _outstanding_seg.front().second );
-    if ( _windows_size > 0 ) {
+    auto it = find_if( _outstanding_seg.begin(), _outstanding_seg.end(), []( const auto& seg ) {
+      return !seg.sacked;
+    } );
+    if ( it == _outstanding_seg.end() )
+      it = _outstanding_seg.begin();
+    // retransmit()会清掉_mtu_probe_seqno，先记下超时的是不是探测报文，是的话下面不通知拥塞控制
+    const bool mtu_probe = is_mtu_probe( *it );
+    if ( it->lost && !it->retransmitted )
+      _lost_seqnos -= it->sequence_length();
+    retransmit( *it, transmit );
+    // 超时之后不再发送探测报文，直到有新的数据被确认
+    _probe_timer.stop();
+    // 不使用坚持计时器时，零窗口下重传的是探测窗口的那一个字节，不退避；否则这是真正的超时
+    if ( _windows_size > 0 || _persist ) {
       ++_consecutive_retransmissions;
-      _timer.set_time_out( _timer.get_time_out() * 2 );
+      uint64_t backoff = _timer.get_time_out() * 2;
+      if ( _adaptive_rto )
+        backoff = min( backoff, _rtt.max_rto() );
+      _timer.set_time_out( backoff );
+      // 超时说明网络严重拥塞，由拥塞控制算法重新开始；超时也结束了之前的恢复期
+      if ( _cc && !mtu_probe )
+        _cc->on_rto( _now_ms, _sequence_numbers_in_flight );
+      _in_recovery = false;
+      _dup_acks = 0;
+      _dupack_seqnos = 0;
+      // 判定丢失的segment的重传也可能丢了，允许下次push时再重传一次
+      for ( auto& seg : _outstanding_seg ) {
+        if ( seg.lost && seg.retransmitted && &seg != &*it ) {
+          seg.retransmitted = false;
+          _lost_seqnos += seg.sequence_length();
+        }
+      }
     }
     _timer.restart();
   }
+
+  // 按发送速率补充令牌，最多补满令牌桶，然后发送令牌允许的segment
+  if ( paced() ) {
+    const auto refill = static_cast<int64_t>( pacing_rate() * ms_since_last_tick );
+    _pacing_credit = min( _pacing_credit + refill, static_cast<int64_t>( _pacing_burst * 1000 ) );
+    push( transmit );
+  }
+
+  // 坚持计时器到期：发送零窗口探测，用一个已经被确认过的seqno，不占用新的序列号，接收方会回复带当前窗口的ACK。
+  // 探测不是重传，不计入连续重传次数；间隔指数增长，最长为最大RTO
+  _persist_timer.tick( ms_since_last_tick );
+  if ( _persist_timer.check_time_out() ) {
+    TCPSenderMessage probe = make_empty_message();
+    probe.seqno = Wrap32::wrap( _next_seqno - 1, isn_ );
+    transmit( probe );
+    _persist_timer.set_time_out( min( uint64_t { _persist_timer.get_time_out() } * 2, _rtt.max_rto() ) );
+    _persist_timer.restart();
+  }
+
+  // cork留着的数据等得太久了，不再等更多的数据
+  _cork_timer.tick( ms_since_last_tick );
+  if ( _cork_timer.check_time_out() )
+    flush( transmit );
+
+  // RACK的重排序窗口到期，重新检查在它之前发送的segment
+  _reorder_timer.tick( ms_since_last_tick );
+  if ( _reorder_timer.check_time_out() ) {
+    _reorder_timer.stop();
+    if ( rack_detect_loss() && !_in_recovery )
+      enter_recovery( false );
+    retransmit_lost( transmit );
+  }
+}
+
+void TCPSender::mark_delivered( const OutstandingSegment& seg, DeliverySample& sample )
+{
+  // 探测报文到达了接收方，路径可以承载这个大小
+  if ( is_mtu_probe( seg ) ) {
+    _mss = _mtu_probe_size;
+    _mtu_probe_seqno.reset();
+    _mtu_probe_failures = 0;
+    if ( _cc )
+      _cc->set_mss( _mss );
+  }
+  if ( _rack_tlp )
+    rack_update( seg );
+  _delivered += seg.sequence_length();
+  // SYN不是数据，不让拥塞窗口因为它多增长一个字节（否则IW10之后的窗口是10 * MSS + 1）
+  sample.any = true;
+  sample.acked += seg.sequence_length() - seg.SYN;
+  // 重传过的segment不知道确认的是哪一次发送，不能用来采样（Karn算法）
+  if ( !seg.retransmitted && ( !sample.sent_ms.has_value() || seg.sent_ms >= sample.sent_ms.value() ) ) {
+    sample.sent_ms = seg.sent_ms;
+    sample.delivered = seg.delivered;
+    sample.delivered_ms = seg.delivered_ms;
+  }
+}
+
+void TCPSender::report_ack( const DeliverySample& sample )
+{
+  if ( !sample.any )
+    return;
+  AckSample ack { .now_ms = _now_ms, .acked = sample.acked, .in_flight = pipe(), .delivered = _delivered };
+  ack.in_recovery = _in_recovery;
+  // 有时间戳回显时用它采样，否则只能用没有重传过的segment的发送时间（Karn算法）
+  if ( sample.echo_rtt.has_value() )
+    ack.rtt_ms = sample.echo_rtt;
+  else if ( sample.sent_ms.has_value() )
+    ack.rtt_ms = _now_ms - sample.sent_ms.value();
+  if ( ack.rtt_ms.has_value() )
+    _rtt.add_sample( ack.rtt_ms.value() );
+  if ( sample.sent_ms.has_value() ) {
+    ack.prior_delivered = sample.delivered;
+    // 发送速率 = 这个segment发出之后到现在被确认的数据量 / 经过的时间
+    const uint64_t interval = _now_ms - sample.delivered_ms;
+    if ( interval > 0 )
+      ack.delivery_rate = ( _delivered - sample.delivered ) * 1000 / interval;
+  }
+  _delivered_ms = _now_ms;
+  if ( _cc )
+    _cc->on_ack( ack );
+}
+
+bool TCPSender::update_scoreboard( const vector<SACKBlock>& sack, DeliverySample& sample )
+{
+  for ( const auto& block : sack ) {
+    const uint64_t left = block.left.unwrap( isn_, _next_seqno );
+    const uint64_t right = block.right.unwrap( isn_, _next_seqno );
+    // 忽略不合理的block
+    if ( left >= right || right > _next_seqno )
+      continue;
+    // 队列按seqno有序，二分找到第一个起点不小于left的segment，把完全落在block里的segment标记为sacked
+    auto it = lower_bound( _outstanding_seg.begin(),
+                           _outstanding_seg.end(),
+                           left,
+                           []( const OutstandingSegment& seg, uint64_t x ) { return seg.seqno < x; } );
+    for ( ; it != _outstanding_seg.end() && it->seqno + it->sequence_length() <= right; ++it ) {
+      if ( it->sacked )
+        continue;
+      it->sacked = true;
+      _sacked_seqnos += it->sequence_length();
+      mark_delivered( *it, sample );
+      if ( it->lost && !it->retransmitted )
+        _lost_seqnos -= it->sequence_length();
+    }
+  }
+
+  // 从后往前数被SACK的segment，某个segment之后已有DUP_THRESH个segment被SACK，就判定它丢失了
+  bool newly_lost = false;
+  unsigned sacked_above = 0;
+  for ( auto it = _outstanding_seg.rbegin(); it != _outstanding_seg.rend(); ++it ) {
+    if ( it->sacked ) {
+      ++sacked_above;
+    } else if ( sacked_above >= TCPConfig::DUP_THRESH && !it->lost ) {
+      newly_lost |= mark_lost( *it );
+    }
+  }
+  return newly_lost;
+}
+
+bool TCPSender::mark_lost( OutstandingSegment& seg )
+{
+  if ( seg.lost )
+    return false;
+  seg.lost = true;
+  if ( !seg.retransmitted )
+    _lost_seqnos += seg.sequence_length();
+  // 返回值决定调用者是否进入恢复期，探测报文的丢失不算
+  return !is_mtu_probe( seg );
+}
+
+void TCPSender::enter_recovery( bool by_dup_acks )
+{
+  _in_recovery = true;
+  _dupack_recovery = by_dup_acks;
+  _probe_timer.stop();
+  _recovery_point = _next_seqno;
+  if ( _cc )
+    _cc->on_loss( _now_ms, _sequence_numbers_in_flight );
+}
+
+void TCPSender::update_newreno( uint64_t abs_ackno, uint64_t acked, uint32_t window_size )
+{
+  // 由SACK进入的恢复期交给记分板处理：填上最后一个空洞的ACK不带SACK block，但它不是NewReno的部分确认
+  if ( _in_recovery && !_dupack_recovery ) {
+    _dup_acks = 0;
+    return;
+  }
+  if ( acked > 0 ) {
+    _dup_acks = 0;
+    if ( !_in_recovery ) {
+      _dupack_seqnos = 0;
+      return;
+    }
+    // 恢复期内的部分确认（RFC 6582）：下一个空洞也丢了，立即重传，不必等到超时
+    if ( !_outstanding_seg.empty() )
+      mark_lost( _outstanding_seg.front() );
+    // 被确认的数据里，除了重传的那个segment，其余的都已经按重复ACK计入了_dupack_seqnos
+    const uint64_t counted = acked - min( acked, _mss );
+    _dupack_seqnos -= min( _dupack_seqnos, counted );
+    return;
+  }
+
+  // 重复ACK：没有确认新数据，ackno等于最早未确认的seqno，窗口也没有变化
+  if ( _outstanding_seg.empty() || abs_ackno != _outstanding_seg.front().seqno || window_size != _windows_size )
+    return;
+  ++_dup_acks;
+  // 每个重复ACK说明接收方又收到了一个segment，它已经离开网络，让出位置发送新数据（RFC 3042、RFC 6582）
+  _dupack_seqnos += min( _mss, pipe() );
+  if ( _dup_acks == TCPConfig::DUP_THRESH && !_in_recovery ) {
+    // 快速重传：第DUP_THRESH个重复ACK，立即重传最早未确认的segment
+    if ( mark_lost( _outstanding_seg.front() ) )
+      enter_recovery( true );
+  }
+}
+
+void TCPSender::rack_update( const OutstandingSegment& seg )
+{
+  const uint64_t rtt = _now_ms - seg.sent_ms;
+  // 重传过的segment，如果RTT比最小RTT还短，这个ACK多半是对原来那次发送的确认，不能用
+  if ( seg.retransmitted && rtt < _rtt.min_rtt() )
+    return;
+  const uint64_t end = seg.seqno + seg.sequence_length();
+  if ( seg.sent_ms > _rack_xmit_ms || ( seg.sent_ms == _rack_xmit_ms && end > _rack_end_seq ) ) {
+    _rack_xmit_ms = seg.sent_ms;
+    _rack_end_seq = end;
+    _rack_rtt = rtt;
+  }
+}
+
+bool TCPSender::rack_detect_loss()
+{
+  // RACK（RFC 8985）：比最近被确认的segment更早发送的segment，超过 RTT + 重排序窗口 还没被确认，就是丢了
+  const uint64_t reo_wnd = _rtt.min_rtt() / 4;
+  uint64_t wait = 0;
+  bool newly_lost = false;
+  for ( auto& seg : _outstanding_seg ) {
+    if ( seg.sacked || ( seg.lost && !seg.retransmitted ) )
+      continue;
+    const uint64_t end = seg.seqno + seg.sequence_length();
+    const bool sent_before
+      = seg.sent_ms < _rack_xmit_ms || ( seg.sent_ms == _rack_xmit_ms && end <= _rack_end_seq );
+    if ( !sent_before || ( seg.sent_ms == _rack_xmit_ms && end == _rack_end_seq ) )
+      continue;
+    const uint64_t deadline = seg.sent_ms + _rack_rtt + reo_wnd;
+    if ( deadline > _now_ms ) {
+      // 还在重排序窗口之内，等到期后再检查
+      wait = max( wait, deadline - _now_ms );
+      continue;
+    }
+    if ( seg.lost ) {
+      // 重传也丢了，再重传一次
+      seg.retransmitted = false;
+      _lost_seqnos += seg.sequence_length();
+      newly_lost = true;
+    } else
+      newly_lost |= mark_lost( seg );
+  }
+  if ( wait > 0 ) {
+    _reorder_timer.set_time_out( wait );
+    _reorder_timer.restart();
+  }
+  return newly_lost;
+}
+
+void TCPSender::arm_probe()
+{
+  if ( !_rack_tlp || _outstanding_seg.empty() || _in_recovery || _probe_pending || !_rtt.has_sample() ) {
+    _probe_timer.stop();
+    return;
+  }
+  // PTO = 2 * SRTT；只有一个segment在途时，接收方可能会推迟ACK，再加上最长的ACK延迟
+  uint64_t pto = 2 * _rtt.srtt();
+  if ( _outstanding_seg.size() == 1 )
+    pto += TCPConfig::MAX_ACK_DELAY;
+  // 探测要赶在RTO之前（RFC 8985 7.2），PTO不超过RTO
+  pto = min( pto, current_RTO_ms() );
+  _probe_timer.set_time_out( max( pto, uint64_t { TCPConfig::MIN_PTO } ) );
+  _probe_timer.restart();
+}
+
+void TCPSender::send_probe( const TransmitFunction& transmit )
+{
+  _probe_timer.stop();
+  if ( _outstanding_seg.empty() )
+    return;
+  // 有新数据并且接收方窗口允许就发送一个新的segment，否则重传最后一个segment
+  const uint64_t windows_size = usable_window();
+  const uint64_t allowance
+    = windows_size > _sequence_numbers_in_flight ? windows_size - _sequence_numbers_in_flight : 0;
+  if ( allowance == 0 || !send_segment( allowance, transmit ) ) {
+    auto& seg = _outstanding_seg.back();
+    if ( seg.lost && !seg.retransmitted )
+      _lost_seqnos -= seg.sequence_length();
+    retransmit( seg, transmit );
+  }
+  _probe_pending = true;
+  _timer.restart();
 }
@@ -1,15 +1,18 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <list>
 #include <memory>
 #include <optional>
-#include <queue>
+#include <vector>
 
 class Timer
 {
@@ -34,14 +37,68 @@ public:
   bool is_open() { return open; }
 };
 
+// RFC 6298 的RTO估计：SRTT和RTTVAR用定点数保存（_srtt8 = 8 * SRTT，_rttvar4 = 4 * RTTVAR），
+// 这样7/8、3/4这些系数不需要浮点运算
+class RTTEstimator
+{
+private:
+  uint64_t _initial_rto;
+  uint64_t _min_rto;
+  uint64_t _max_rto;
+  uint64_t _srtt8 = 0;
+  uint64_t _rttvar4 = 0;
+  uint64_t _min_rtt = 0;
+  bool _has_sample = false;
+
+public:
+  RTTEstimator( uint64_t initial_rto, uint64_t min_rto, uint64_t max_rto )
+    : _initial_rto( initial_rto ), _min_rto( min_rto ), _max_rto( max_rto )
+  {}
+  void add_sample( uint64_t rtt_ms );
+  uint64_t srtt() const { return _srtt8 / 8; }
+  uint64_t rttvar() const { return _rttvar4 / 4; }
+  uint64_t min_rtt() const { return _min_rtt; }
+  bool has_sample() const { return _has_sample; }
+  uint64_t max_rto() const { return _max_rto; }
+  // 还没有RTT样本时使用初始RTO；结果总在[min_rto, max_rto]之内（调用者保证min_rto <= max_rto）
+  uint64_t rto() const;
+};
+
+// 已经发送但是没有被确认的segment，以及它在SACK记分板(scoreboard)上的状态。
+// payload本身留在input_中，直到被确认才pop，（重新）发送时再从input_中取出，这样每个字节只保存一份
+struct OutstandingSegment
+{
+  uint64_t seqno;             // absolute seqno
+  uint64_t payload_size;      // payload的字节数
+  bool SYN;                   // 是否带SYN
+  bool FIN;                   // 是否带FIN
+  uint64_t sent_ms;           // 发送时间，用于RTT采样
+  uint64_t delivered;         // 发送时累计被确认的序列号个数，用于发送速率采样
+  uint64_t delivered_ms;      // 发送时最近一次有数据被确认的时间
+  bool sacked = false;        // 接收方通过SACK告知已经收到
+  bool lost = false;          // 之后已有DUP_THRESH个segment被SACK，判定为丢失
+  bool retransmitted = false; // 已经重传过（快速重传或超时重传）
+
+  uint64_t sequence_length() const { return SYN + payload_size + FIN; }
+  // payload第一个字节在stream中的下标
+  uint64_t stream_index() const { return seqno + SYN - 1; }
+};
+
 class TCPSender
 {
 public:
   /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
   TCPSender( ByteStream&& input, Wrap32 isn, uint64_t initial_RTO_ms )
-    : input_( std::move( input ) ), isn_( isn ), initial_RTO_ms_( initial_RTO_ms ), _timer( initial_RTO_ms_ )
+    : input_( std::move( input ) )
+    , isn_( isn )
+    , initial_RTO_ms_( initial_RTO_ms )
+    , _timer( initial_RTO_ms_ )
+    , _rtt( initial_RTO_ms_, TCPConfig::MIN_RTO_DFLT, TCPConfig::MAX_RTO_DFLT )
   {}
 
+  /* Construct TCP sender with the ISN, RTO and congestion control algorithm given in the config */
+  TCPSender( ByteStream&& input, const TCPConfig& cfg );
+
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage make_empty_message() const;
 
@@ -60,6 +117,25 @@ public:
   // Accessors
   uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
   uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+  uint64_t congestion_window() const;           // Congestion window in sequence numbers (UINT64_MAX if none)
+  uint64_t pacing_rate() const;                 // Pacing rate in bytes per second (0 if unpaced)
+  bool paced() const;                           // Is the token bucket limiting what push() sends?
+  uint64_t smoothed_rtt() const;                // SRTT in milliseconds (0 before the first RTT sample)
+  uint64_t rtt_variation() const;               // RTTVAR in milliseconds
+  uint64_t current_RTO_ms() const;              // RTO the timer restarts with on a new ACK (before backoff)
+  uint64_t mss() const;                         // Largest payload plus options of a segment (grows with PLPMTUD)
+  bool fin_sent() const { return FIN; }         // Has the FIN been sent (though perhaps not yet acknowledged)?
+  uint32_t timestamp() const { return static_cast<uint32_t>( _now_ms ); } // Clock sent as TSval, in ms
+
+  /* Send whatever Nagle or cork mode is holding back, including bytes written since the last push */
+  void flush( const TransmitFunction& transmit );
+
+  /* The MSS the peer's SYN advertised (TCPConfig::DEFAULT_MSS if it had none): no segment may be bigger */
+  void set_peer_mss( uint64_t mss );
+
+  /* Bytes of TCP options the segments sent from now on carry: they come out of the MSS (RFC 6691) */
+  void set_options_length( uint64_t len );
+
   Writer& writer() { return input_.writer(); }
   const Writer& writer() const { return input_.writer(); }
 
@@ -67,6 +143,73 @@ public:
   const Reader& reader() const { return input_.reader(); }
 
 private:
+  // 一次ACK新确认的数据，以及其中最近发出的（没有重传过的）segment的发送状态，用于RTT和发送速率采样
+  struct DeliverySample
+  {
+    bool any = false; // 有segment被新确认（只确认了SYN时acked为0，但仍然有RTT样本）
+    uint64_t acked = 0;
+    std::optional<uint64_t> sent_ms {};
+    uint64_t delivered = 0;
+    uint64_t delivered_ms = 0;
+    std::optional<uint64_t> echo_rtt {}; // 根据回显的时间戳得到的RTT
+  };
+
+  // 根据记录的segment生成要（重新）发送的报文，带上当前的时间戳；
+  // offset和max_len用来把比MSS大的segment拆开重传
+  TCPSenderMessage make_message( const OutstandingSegment& seg,
+                                 uint64_t offset = 0,
+                                 uint64_t max_len = UINT64_MAX ) const;
+  // 重传一个segment
+  void retransmit( OutstandingSegment& seg, const TransmitFunction& transmit );
+  // 每个segment最多携带的payload：MSS减去选项的长度
+  uint64_t payload_limit() const;
+  // PLPMTUD：下一个探测报文的大小（payload加上选项），0表示现在不探测
+  uint64_t mtu_probe_size() const;
+  // seg是不是正在进行的探测报文；探测报文丢失多半是因为太大，不是拥塞，所以它的丢失不减小拥塞窗口
+  bool is_mtu_probe( const OutstandingSegment& seg ) const { return _mtu_probe_seqno == seg.seqno; }
+  // input_中还没有发送过的字节数
+  uint64_t unsent_bytes() const;
+  // 根据SACK block更新记分板，返回是否有新的segment被判定丢失
+  bool update_scoreboard( const std::vector<SACKBlock>& sack, DeliverySample& sample );
+  // 记录一个segment被接收方收到（累计确认或SACK）
+  void mark_delivered( const OutstandingSegment& seg, DeliverySample& sample );
+  // 用ACK的信息更新RTT估计，并交给拥塞控制算法
+  void report_ack( const DeliverySample& sample );
+  // 把segment标记为丢失，下次push时重传；返回这次丢失是否说明发生了拥塞
+  bool mark_lost( OutstandingSegment& seg );
+  // 判定丢包，进入恢复期；by_dup_acks表示丢包是由重复ACK（而不是SACK或RACK）判定的
+  void enter_recovery( bool by_dup_acks );
+  // 重传判定为丢失的segment
+  void retransmit_lost( const TransmitFunction& transmit );
+  // 发送一个新的segment（最多占用allowance个序列号），没有可发送的内容时返回false
+  bool send_segment( uint64_t allowance, const TransmitFunction& transmit );
+  // RACK：记录最近发送的被确认的segment
+  void rack_update( const OutstandingSegment& seg );
+  // RACK：根据发送时间判断丢包，返回是否有新的segment被判定丢失
+  bool rack_detect_loss();
+  // TLP：设置/取消探测计时器
+  void arm_probe();
+  // TLP：发送探测报文
+  void send_probe( const TransmitFunction& transmit );
+  // 没有SACK时根据重复ACK快速重传，并按NewReno进行快速恢复
+  void update_newreno( uint64_t abs_ackno, uint64_t acked, uint32_t window_size );
+  // 还在网络中的序列号个数：未确认的，减去被SACK的、判定丢失但还没重传的、重复ACK表明已经到达的
+  uint64_t pipe() const
+  {
+    const uint64_t left_network = _sacked_seqnos + _lost_seqnos + _dupack_seqnos;
+    return _sequence_numbers_in_flight > left_network ? _sequence_numbers_in_flight - left_network : 0;
+  }
+  // 接收方窗口和拥塞窗口都允许的情况下，现在还能发送的序列号个数
+  uint64_t send_allowance( uint64_t windows_size ) const;
+  // 发送时使用的接收方窗口：不使用坚持计时器时，零窗口当作1，用一个字节的数据探测
+  uint64_t usable_window() const;
+  // 接收方窗口为零而又有数据要发送时启动坚持计时器，否则停止它
+  void update_persist();
+  // Nagle/cork：剩下的unsent个字节不足一个MSS，是否先留着等更多的数据
+  bool hold_small_segment( uint64_t unsent ) const;
+  // 发送出去的字节留在input_中直到被确认：扩大input_，让应用仍然可以写入_send_capacity个字节
+  void grow_send_buffer();
+
   // Variables initialized in constructor
   ByteStream input_;
   Wrap32 isn_;
@@ -77,6 +220,46 @@ private:
   uint64_t _sequence_numbers_in_flight = 0;                              // 未被确认的字节大小
   uint32_t _windows_size = 1;                                            // 接收方窗口大小
   uint64_t _next_seqno { 0 };                                            // 下一个报文的序列号
-  std::queue<std::pair<uint64_t, TCPSenderMessage>> _outstanding_seg {}; //已经发送但是没有被确认的segment队列
+  std::deque<OutstandingSegment> _outstanding_seg {};                    //已经发送但是没有被确认的segment队列
+  uint64_t _sacked_seqnos = 0;                                           // 已被SACK的序列号个数
+  uint64_t _lost_seqnos = 0;                                             // 判定丢失但还未重传的序列号个数
+  std::unique_ptr<CongestionController> _cc {};                          // 拥塞控制算法，为空则不限制
+  uint64_t _now_ms = 0;                                                  // tick累计的时间
+  uint64_t _delivered = 0;                                               // 累计被确认的序列号个数
+  uint64_t _delivered_ms = 0;                                            // 最近一次有数据被确认的时间
+  bool _in_recovery = false;                                             // 是否处于丢包恢复期
+  uint64_t _recovery_point = 0;                                          // ackno越过它时结束恢复期
+  bool _dupack_recovery = false;                                         // 当前恢复期是由重复ACK（而不是SACK）进入的
+  RTTEstimator _rtt;                                                     // RTT和RTO的估计
+  bool _adaptive_rto = false;                                            // 是否使用估计出的RTO
+  bool _fast_retransmit = false;                                         // 是否根据重复ACK快速重传
+  uint64_t _dup_acks = 0;                                                // 连续收到的重复ACK个数
+  uint64_t _dupack_seqnos = 0;                                           // 重复ACK表明已经到达接收方的序列号个数
+  bool _rack_tlp = false;                                                // 是否启用RACK-TLP
+  uint64_t _rack_xmit_ms = 0;                                            // 被确认的segment中最晚的发送时间
+  uint64_t _rack_end_seq = 0;                                            // 这个segment的结束seqno
+  uint64_t _rack_rtt = 0;                                                // 这个segment的RTT
+  Timer _reorder_timer {};                                               // RACK的重排序计时器
+  Timer _probe_timer {};                                                 // TLP的探测计时器
+  bool _probe_pending = false;                                           // 已发送探测报文，还没有新的确认
+  bool _pacing = false;                                                  // 是否按速率发送
+  uint64_t _fixed_pacing_rate = 0;                                       // 配置的发送速率，0表示由拥塞控制算法决定
+  uint64_t _pacing_burst = 0;                                            // 令牌桶的容量（字节）
+  int64_t _pacing_credit = 0;                                            // 令牌桶中的令牌，单位：1/1000字节
+  uint64_t _mss = TCPConfig::MAX_PAYLOAD_SIZE;                           // 每个segment的payload加上选项最多的字节数
+  uint64_t _options_len = 0;                                             // 每个segment携带的选项的字节数
+  bool _mtu_probing = false;                                             // 是否进行PLPMTUD
+  uint64_t _mtu_probe_high = TCPConfig::MAX_PAYLOAD_SIZE;                // 还没有被排除的最大payload
+  std::optional<uint64_t> _mtu_probe_seqno {};                           // 在途的探测报文的seqno
+  uint64_t _mtu_probe_size = 0;                                          // 探测报文的大小（payload加上选项）
+  unsigned _mtu_probe_failures = 0;                                      // 这个大小的探测报文丢失的次数
+  bool _persist = false;                                                 // 是否用坚持计时器探测零窗口
+  Timer _persist_timer {};                                               // 坚持计时器
+  bool _nagle = false;                                                   // 有未确认的数据时是否留着不足MSS的数据
+  bool _cork = false;                                                    // 是否留着不足MSS的数据直到flush
+  uint64_t _flush_upto = 0;                                              // flush时写入的字节数，之前的数据不再留着
+  Timer _cork_timer {};                                                  // cork留着数据的最长时间
+  uint64_t _send_capacity = 0;                                           // 留给应用写入（还没有发送）的字节数
+  uint64_t _max_send_capacity = 0;                                       // input_最多扩大到的容量，0表示不扩大
   bool SYN = false, FIN = false;
 };
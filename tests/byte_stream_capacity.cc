@@ -1,8 +1,10 @@
 #include "byte_stream.hh"
 #include "byte_stream_test_harness.hh"
 
+#include <cstdint>
 #include <exception>
 #include <iostream>
+#include <string>
 
 using namespace std;
 
@@ -97,6 +99,67 @@ int main()
       test.execute( BytesBuffered { 1 } );
     }
 
+    {
+      ByteStreamTestHarness test { "grow keeps wrapped bytes in order", 4 };
+      test.execute( Push { "abcd" } );
+      test.execute( Pop { 3 } );
+      test.execute( Push { "efg" } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Grow { 10 } );
+      test.execute( AvailableCapacity { 6 } );
+      test.execute( BytesBuffered { 4 } );
+      test.execute( Peek { "defg" } );
+      test.execute( Push { "hijklmn" } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( ReadAll { "defghijklm" } );
+
+      // the capacity never shrinks
+      test.execute( Grow { 2 } );
+      test.execute( AvailableCapacity { 10 } );
+    }
+
+    {
+      // the ring buffer is allocated lazily, so even a capacity no buffer could hold is fine
+      ByteStreamTestHarness test { "huge capacity", UINT64_MAX };
+      test.execute( AvailableCapacity { UINT64_MAX } );
+      test.execute( Push { "hello" } );
+      test.execute( AvailableCapacity { UINT64_MAX - 5 } );
+      test.execute( ReadAll { "hello" } );
+    }
+
+    {
+      // the ring doubles while wrapped bytes are buffered
+      ByteStreamTestHarness test { "ring grows in place", 20000 };
+      test.execute( Push { string( 3000, 'a' ) } );
+      test.execute( Pop { 2000 } );
+      test.execute( Push { string( 2000, 'b' ) } );
+      test.execute( Push { string( 6000, 'c' ) } );
+      test.execute( BytesBuffered { 9000 } );
+      test.execute( AvailableCapacity { 11000 } );
+      test.execute( ReadAll { string( 1000, 'a' ) + string( 2000, 'b' ) + string( 6000, 'c' ) } );
+    }
+
+    {
+      ByteStreamTestHarness test { "grow: chunked", 2, ByteStream::Mode::Chunked };
+      test.execute( Push { "ab" } );
+      test.execute( Grow { 5 } );
+      test.execute( AvailableCapacity { 3 } );
+      test.execute( Push { "cdef" } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( ReadAll { "abcde" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "grow: pipe", 64, ByteStream::Mode::Pipe };
+      test.execute( Push { string( 64, 'a' ) } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Grow { 100 } );
+      test.execute( AvailableCapacity { 36 } );
+      test.execute( Push { string( 40, 'b' ) } );
+      test.execute( BytesPushed { 100 } );
+      test.execute( ReadAll { string( 64, 'a' ) + string( 36, 'b' ) } );
+    }
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
@@ -0,0 +1,71 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "chunked: peek returns the front chunk", 15, ByteStream::Mode::Chunked };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "dog" } );
+      test.execute( BytesPushed { 6 } );
+      test.execute( BytesBuffered { 6 } );
+      test.execute( AvailableCapacity { 9 } );
+      test.execute( PeekOnce { "cat" } );
+      test.execute( Peek { "catdog" } );
+
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "t" } );
+      test.execute( BytesPopped { 2 } );
+      test.execute( BytesBuffered { 4 } );
+
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "og" } );
+      test.execute( BytesBuffered { 2 } );
+      test.execute( AvailableCapacity { 13 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunked: push beyond capacity is truncated", 5, ByteStream::Mode::Chunked };
+
+      test.execute( Push { "abc" } );
+      test.execute( Push { "defgh" } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekOnce { "abc" } );
+      test.execute( Peek { "abcde" } );
+
+      test.execute( Pop { 3 } );
+      test.execute( PeekOnce { "de" } );
+      test.execute( Push { "xyz" } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( Peek { "dexyz" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunked: empty pushes and close", 4, ByteStream::Mode::Chunked };
+
+      test.execute( Push { "" } );
+      test.execute( BufferEmpty { true } );
+      test.execute( PeekOnce { "" } );
+      test.execute( Push { "ab" } );
+      test.execute( Push { "" } );
+      test.execute( Close {} );
+      test.execute( IsFinished { false } );
+      test.execute( Pop { 5 } );
+      test.execute( BytesPopped { 2 } );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,243 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <array>
+#include <exception>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+struct WriteFrom : public Action<ByteStream>
+{
+  FileDescriptor& fd_;
+  uint64_t expected_;
+
+  WriteFrom( FileDescriptor& fd, uint64_t expected ) : fd_( fd ), expected_( expected ) {}
+  std::string description() const override { return "write_from( fd ) reads " + to_string( expected_ ); }
+  void execute( ByteStream& bs ) const override
+  {
+    const uint64_t got = bs.writer().write_from( fd_ );
+    if ( got != expected_ ) {
+      throw ExpectationViolation { "write_from", expected_, got };
+    }
+  }
+};
+
+struct ReadInto : public Expectation<ByteStream>
+{
+  std::string output_;
+  size_t len_;
+
+  ReadInto( std::string output, size_t len ) : output_( move( output ) ), len_( len ) {}
+  std::string description() const override
+  {
+    return "read_into( " + to_string( len_ ) + "-byte span ) gives \"" + Printer::prettify( output_ ) + "\"";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    std::string got( len_, 0 );
+    got.resize( bs.reader().read_into( got ) );
+    if ( got != output_ ) {
+      throw ExpectationViolation { "Expected to read \"" + Printer::prettify( output_ ) + "\", but found \""
+                                   + Printer::prettify( got ) + "\"" };
+    }
+  }
+};
+
+struct WriteTo : public Action<ByteStream>
+{
+  FileDescriptor& fd_;
+  uint64_t expected_;
+
+  WriteTo( FileDescriptor& fd, uint64_t expected ) : fd_( fd ), expected_( expected ) {}
+  std::string description() const override { return "write_to( fd ) writes " + to_string( expected_ ); }
+  void execute( ByteStream& bs ) const override
+  {
+    const uint64_t got = bs.reader().write_to( fd_ );
+    if ( got != expected_ ) {
+      throw ExpectationViolation { "write_to", expected_, got };
+    }
+  }
+};
+
+struct WriteAllTo : public WriteTo
+{
+  using WriteTo::WriteTo;
+  std::string description() const override { return "write_to( fd ) until empty writes " + to_string( expected_ ); }
+  void execute( ByteStream& bs ) const override
+  {
+    uint64_t got = 0;
+    while ( bs.reader().bytes_buffered() ) {
+      got += bs.reader().write_to( fd_ );
+    }
+    if ( got != expected_ ) {
+      throw ExpectationViolation { "total written by write_to", expected_, got };
+    }
+  }
+};
+
+pair<FileDescriptor, FileDescriptor> make_pipe()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+void fd_test( ByteStream::Mode mode )
+{
+  auto [rd, wr] = make_pipe();
+  rd.set_blocking( false );
+
+  ByteStreamTestHarness test { "write_from and read_into", 8, mode };
+
+  wr.write( "hello, world" );
+  test.execute( WriteFrom { rd, 8 } );
+  test.execute( BytesPushed { 8 } );
+  test.execute( AvailableCapacity { 0 } );
+  test.execute( WriteFrom { rd, 0 } );
+
+  test.execute( ReadInto { "hel", 3 } );
+  test.execute( BytesPopped { 3 } );
+  test.execute( WriteFrom { rd, 3 } );
+  test.execute( ReadInto { "lo, worl", 16 } );
+  test.execute( BufferEmpty { true } );
+  test.execute( WriteFrom { rd, 1 } );
+  test.execute( ReadInto { "d", 4 } );
+  test.execute( ReadInto { "", 4 } );
+
+  // a non-blocking read with nothing to read
+  test.execute( WriteFrom { rd, 0 } );
+  if ( rd.eof() ) {
+    throw runtime_error( "EOF reported before the write end was closed" );
+  }
+
+  wr.close();
+  test.execute( WriteFrom { rd, 0 } );
+  if ( not rd.eof() ) {
+    throw runtime_error( "EOF not reported after the write end was closed" );
+  }
+}
+
+void expect_read( FileDescriptor& fd, const string& expected )
+{
+  string got( expected.size() + 1, 0 );
+  got.resize( fd.read( span { got } ) );
+  if ( got != expected ) {
+    throw runtime_error( "Expected to read \"" + Printer::prettify( expected ) + "\" from fd, but found \""
+                         + Printer::prettify( got ) + "\"" );
+  }
+}
+
+void copy_test( ByteStream::Mode mode )
+{
+  auto [src_rd, src_wr] = make_pipe();
+  auto [dst_rd, dst_wr] = make_pipe();
+  src_rd.set_blocking( false );
+  dst_rd.set_blocking( false );
+
+  ByteStreamTestHarness test { "write_from one fd, write_to another", 16, mode };
+
+  src_wr.write( "abcdefghij" );
+  test.execute( WriteFrom { src_rd, 10 } );
+  test.execute( WriteTo { dst_wr, 10 } );
+  test.execute( BufferEmpty { true } );
+  test.execute( BytesPopped { 10 } );
+  test.execute( WriteTo { dst_wr, 0 } );
+  expect_read( dst_rd, "abcdefghij" );
+
+  // bytes already looked at with peek() must be written before the ones still in the stream
+  src_wr.write( "klmnop" );
+  test.execute( WriteFrom { src_rd, 6 } );
+  test.execute( PeekOnce { "klmnop" } );
+  test.execute( Push { "qrs" } );
+  test.execute( Pop { 2 } );
+  test.execute( WriteAllTo { dst_wr, 7 } );
+  test.execute( BytesPopped { 19 } );
+  expect_read( dst_rd, "mnopqrs" );
+
+  // pop() past what peek() has already looked at
+  src_wr.write( "tuvwxyz" );
+  test.execute( WriteFrom { src_rd, 7 } );
+  test.execute( PeekOnce { "tuvwxyz" } );
+  test.execute( Pop { 1 } );
+  test.execute( Push { "0123" } );
+  test.execute( Pop { 8 } );
+  test.execute( ReadInto { "23", 4 } );
+  test.execute( BytesPopped { 30 } );
+}
+
+// a partly read page still takes one of the pipe's slots
+void pipe_slots_test()
+{
+  {
+    ByteStreamTestHarness test { "pipe: capacity leaves room for a partly read page", 65536, ByteStream::Mode::Pipe };
+    test.execute( Push { string( 65536, 'a' ) } );
+    test.execute( Pop { 100 } );
+    test.execute( AvailableCapacity { 100 } );
+    test.execute( Push { string( 100, 'b' ) } );
+    test.execute( BytesPushed { 65636 } );
+    test.execute( ReadAll { string( 65436, 'a' ) + string( 100, 'b' ) } );
+  }
+
+  // a pipe as large as pipe-max-size (1 MiB by default) keeps nearly all of it, not the default 64 KiB
+  {
+    const ByteStream large { 1048576, ByteStream::Mode::Pipe };
+    if ( large.capacity() < 1048576 - 65536 ) {
+      throw runtime_error( "a 1 MiB Pipe-mode stream kept only " + to_string( large.capacity() ) + " bytes" );
+    }
+  }
+
+  // spliced bytes cannot be merged, so one-byte splices can fill every slot long before the capacity
+  auto [rd, wr] = make_pipe();
+  rd.set_blocking( false );
+  ByteStream stream { 8000, ByteStream::Mode::Pipe };
+  uint64_t spliced = 0;
+  for ( ;; ) {
+    wr.write( "x" );
+    if ( stream.writer().write_from( rd ) == 0 ) {
+      break;
+    }
+    spliced++;
+  }
+  stream.reader().pop( 1 );
+
+  // the bytes the pipe has no room for must still be kept, in order
+  const string data( 5000, 'b' );
+  stream.writer().push( data );
+  if ( stream.writer().bytes_pushed() != spliced + data.size() ) {
+    throw runtime_error( "push into a pipe with fragmented slots dropped bytes" );
+  }
+  stream.writer().push( "c" );
+  string got;
+  read( stream.reader(), stream.reader().bytes_buffered(), got );
+  if ( got != string( spliced - 1, 'x' ) + data + "c" ) {
+    throw runtime_error( "pipe with fragmented slots returned the wrong bytes" );
+  }
+  if ( stream.writer().write_from( rd ) != 1 || stream.reader().peek() != "x" ) {
+    throw runtime_error( "write_from after draining a fragmented pipe returned the wrong bytes" );
+  }
+}
+
+int main()
+{
+  try {
+    fd_test( ByteStream::Mode::Ring );
+    fd_test( ByteStream::Mode::Chunked );
+    fd_test( ByteStream::Mode::Pipe );
+    copy_test( ByteStream::Mode::Ring );
+    copy_test( ByteStream::Mode::Chunked );
+    copy_test( ByteStream::Mode::Pipe );
+    pipe_slots_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
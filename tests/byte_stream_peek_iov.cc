@@ -0,0 +1,141 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+using namespace std;
+
+static_assert( not is_copy_constructible_v<ByteStream> and is_move_constructible_v<ByteStream>,
+               "a ByteStream should be move-only" );
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "peek_iov: ring buffer without wrap-around", 8 };
+
+      test.execute( PeekIov { {} } );
+      test.execute( Push { "cat" } );
+      test.execute( PeekIov { { "cat" } } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekIov { { "at" } } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_iov: ring buffer wraps around", 8 };
+
+      test.execute( Push { "abcdef" } );
+      test.execute( Pop { 5 } );
+      test.execute( Push { "ghijk" } );
+      test.execute( PeekOnce { "fgh" } );
+      test.execute( PeekIov { { "fgh", "ijk" } } );
+      test.execute( PeekIov { { "fgh" }, 1 } );
+      test.execute( PeekIov { {}, 0 } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekIov { { "jk" } } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_iov: one view per chunk", 15, ByteStream::Mode::Chunked };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "" } );
+      test.execute( Push { "dog" } );
+      test.execute( Push { "emu" } );
+      test.execute( PeekIov { { "cat", "dog", "emu" } } );
+      test.execute( PeekIov { { "cat", "dog" }, 2 } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekIov { { "og", "emu" } } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_at: ring buffer", 8 };
+
+      test.execute( Push { "abcdef" } );
+      test.execute( Pop { 5 } );
+      test.execute( Push { "ghijk" } );
+      test.execute( PeekAt { 0, "fgh" } );
+      test.execute( PeekAt { 2, "h" } );
+      test.execute( PeekAt { 3, "ijk" } );
+      test.execute( PeekAt { 5, "k" } );
+      test.execute( PeekAt { 6, "" } );
+      test.execute( Slice { 1, 4, "ghij" } );
+      test.execute( Slice { 4, 10, "jk" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_at: chunks", 15, ByteStream::Mode::Chunked };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "dog" } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekAt { 0, "at" } );
+      test.execute( PeekAt { 1, "t" } );
+      test.execute( PeekAt { 2, "dog" } );
+      test.execute( PeekAt { 4, "g" } );
+      test.execute( PeekAt { 5, "" } );
+      test.execute( Slice { 1, 3, "tdo" } );
+      test.execute( Slice { 0, 5, "atdog" } );
+      test.execute( Slice { 5, 1, "" } );
+
+      // the chunk index follows chunks popped off the front
+      test.execute( Pop { 3 } );
+      test.execute( Push { "emu" } );
+      test.execute( Push { "yak" } );
+      test.execute( PeekAt { 0, "og" } );
+      test.execute( PeekAt { 2, "emu" } );
+      test.execute( PeekAt { 6, "ak" } );
+      test.execute( PeekAt { 8, "" } );
+      test.execute( Slice { 1, 6, "gemuya" } );
+      test.execute( Slice { 3, 10, "muyak" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_at: pipe", 64, ByteStream::Mode::Pipe };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "dog" } );
+      test.execute( PeekAt { 4, "og" } );
+      test.execute( PeekOnce { "catdog" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "emu" } );
+      test.execute( PeekAt { 3, "g" } );
+      test.execute( PeekAt { 4, "emu" } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekAt { 0, "emu" } );
+      test.execute( Slice { 1, 2, "mu" } );
+    }
+
+    {
+      // reading further into the pipe must not move the bytes an earlier peek() returned
+      ByteStream stream { 65536, ByteStream::Mode::Pipe };
+      string data;
+      for ( size_t i = 0; i < 40000; i++ ) {
+        data += static_cast<char>( 'a' + i % 26 );
+      }
+      stream.writer().push( data );
+      const string_view first = stream.reader().peek();
+      const string copy { first };
+      if ( stream.reader().peek_at( 39000 ) != string_view { data }.substr( 39000 ).substr( 0, 1000 ) ) {
+        throw runtime_error( "peek_at: pipe returned the wrong bytes" );
+      }
+      if ( stream.reader().slice( 100, 39000 ) != data.substr( 100, 39000 ) ) {
+        throw runtime_error( "slice: pipe returned the wrong bytes" );
+      }
+      if ( first != copy ) {
+        throw runtime_error( "peek_at: pipe invalidated the view returned by peek()" );
+      }
+    }
+
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -3,9 +3,11 @@
 #include "byte_stream.hh"
 #include "common.hh"
 
+#include <algorithm>
 #include <concepts>
 #include <optional>
 #include <utility>
+#include <vector>
 
 static_assert( sizeof( Reader ) == sizeof( ByteStream ),
                "Please add member variables to the ByteStream base, not the ByteStream Reader." );
@@ -16,8 +18,11 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name, uint64_t capacity, ByteStream::Mode mode = ByteStream::Mode::Ring )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity )
+                     + ( mode == ByteStream::Mode::Chunked ? ", chunked" : "" ),
+                   ByteStream { capacity, mode } )
   {}
 
   size_t peek_size() { return object().reader().peek().size(); }
@@ -55,6 +60,15 @@ struct Pop : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.reader().pop( len_ ); }
 };
 
+struct Grow : public Action<ByteStream>
+{
+  uint64_t capacity_;
+
+  explicit Grow( uint64_t capacity ) : capacity_( capacity ) {}
+  std::string description() const override { return "grow( " + std::to_string( capacity_ ) + " )"; }
+  void execute( ByteStream& bs ) const override { bs.grow( capacity_ ); }
+};
+
 /* expectations */
 
 struct Peek : public Expectation<ByteStream>
@@ -67,24 +81,22 @@ struct Peek : public Expectation<ByteStream>
 
   void execute( ByteStream& bs ) const override
   {
-    const ByteStream orig = bs;
+    // A ByteStream cannot be copied, so walk the buffer with peek() and peek_at() instead of popping it.
     std::string got;
 
-    while ( bs.reader().bytes_buffered() ) {
-      auto peeked = bs.reader().peek();
+    while ( got.size() < bs.reader().bytes_buffered() ) {
+      auto peeked = got.empty() ? bs.reader().peek() : bs.reader().peek_at( got.size() );
       if ( peeked.empty() ) {
-        throw ExpectationViolation { "Reader::peek() returned empty string_view" };
+        throw ExpectationViolation { got.empty() ? "Reader::peek() returned empty string_view"
+                                                 : "Reader::peek_at() returned empty string_view" };
       }
       got += peeked;
-      bs.reader().pop( peeked.size() );
     }
 
     if ( got != output_ ) {
       throw ExpectationViolation { "Expected \"" + Printer::prettify( output_ ) + "\" in buffer, " + " but found \""
                                    + Printer::prettify( got ) + "\"" };
     }
-
-    bs = orig;
   }
 };
 
@@ -107,6 +119,87 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekAt : public Expectation<ByteStream>
+{
+  uint64_t offset_;
+  std::string output_;
+
+  PeekAt( uint64_t offset, std::string output ) : offset_( offset ), output_( move( output ) ) {}
+
+  std::string description() const override
+  {
+    return "peek_at( " + std::to_string( offset_ ) + " ) gives exactly \"" + Printer::prettify( output_ ) + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    auto peeked = bs.reader().peek_at( offset_ );
+    if ( peeked != output_ ) {
+      throw ExpectationViolation { "Expected exactly \"" + Printer::prettify( output_ ) + "\" at offset "
+                                   + std::to_string( offset_ ) + ", but found \"" + Printer::prettify( peeked )
+                                   + "\"" };
+    }
+  }
+};
+
+struct Slice : public Expectation<ByteStream>
+{
+  uint64_t offset_;
+  uint64_t len_;
+  std::string output_;
+
+  Slice( uint64_t offset, uint64_t len, std::string output )
+    : offset_( offset ), len_( len ), output_( move( output ) )
+  {}
+
+  std::string description() const override
+  {
+    return "slice( " + std::to_string( offset_ ) + ", " + std::to_string( len_ ) + " ) gives \""
+           + Printer::prettify( output_ ) + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto sliced = bs.reader().slice( offset_, len_ );
+    if ( sliced != output_ ) {
+      throw ExpectationViolation { "Expected \"" + Printer::prettify( output_ ) + "\", but found \""
+                                   + Printer::prettify( sliced ) + "\"" };
+    }
+  }
+};
+
+struct PeekIov : public Expectation<ByteStream>
+{
+  std::vector<std::string> output_;
+  size_t max_views_;
+
+  explicit PeekIov( std::vector<std::string> output, size_t max_views = 64 )
+    : output_( move( output ) ), max_views_( max_views )
+  {}
+
+  static std::string prettify( const auto& views )
+  {
+    std::string ret;
+    for ( const auto& v : views ) {
+      ret += ( ret.empty() ? "\"" : ", \"" ) + Printer::prettify( v ) + "\"";
+    }
+    return "[" + ret + "]";
+  }
+
+  std::string description() const override
+  {
+    return "peek_iov( " + std::to_string( max_views_ ) + " ) gives " + prettify( output_ );
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto views = bs.reader().peek_iov( max_views_ );
+    if ( not std::equal( views.begin(), views.end(), output_.begin(), output_.end() ) ) {
+      throw ExpectationViolation { "Expected " + prettify( output_ ) + " but found " + prettify( views ) };
+    }
+  }
+};
+
 struct IsClosed : public ConstExpectBool<ByteStream>
 {
   using ConstExpectBool::ConstExpectBool;
@@ -0,0 +1,235 @@
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// One direction of an emulated path: a drop-tail queue drained at a fixed rate, followed by a fixed
+// propagation delay. Time advances in 1 ms steps.
+template<class Message>
+class Link
+{
+public:
+  Link( uint64_t bytes_per_ms, uint64_t delay_ms, uint64_t queue_limit ) // NOLINT(*-swappable-parameters)
+    : bytes_per_ms_( bytes_per_ms ), delay_ms_( delay_ms ), queue_limit_( queue_limit )
+  {}
+
+  void send( Message msg, uint64_t size, uint64_t now )
+  {
+    if ( queued_bytes_ + size > queue_limit_ ) {
+      ++drops_;
+      return;
+    }
+    queued_bytes_ += size;
+    queue_.push_back( { move( msg ), size, now } );
+  }
+
+  // Move whatever the bottleneck can serialize in this millisecond onto the wire
+  void tick( uint64_t now )
+  {
+    credit_ += bytes_per_ms_;
+    while ( not queue_.empty() and queue_.front().size <= credit_ ) {
+      auto& front = queue_.front();
+      credit_ -= front.size;
+      queued_bytes_ -= front.size;
+      queueing_delay_ += now - front.enqueued;
+      ++packets_;
+      wire_.push_back( { move( front.msg ), now + delay_ms_ } );
+      queue_.pop_front();
+    }
+    if ( queue_.empty() ) {
+      credit_ = 0; // an idle link cannot bank transmission time
+    }
+  }
+
+  template<class F>
+  void deliver( uint64_t now, F&& receive )
+  {
+    while ( not wire_.empty() and wire_.front().arrival <= now ) {
+      receive( wire_.front().msg );
+      wire_.pop_front();
+    }
+  }
+
+  uint64_t drops() const { return drops_; }
+  double mean_queueing_delay() const
+  {
+    return packets_ ? static_cast<double>( queueing_delay_ ) / static_cast<double>( packets_ ) : 0;
+  }
+
+private:
+  struct Queued
+  {
+    Message msg;
+    uint64_t size;
+    uint64_t enqueued;
+  };
+  struct InFlight
+  {
+    Message msg;
+    uint64_t arrival;
+  };
+
+  uint64_t bytes_per_ms_;
+  uint64_t delay_ms_;
+  uint64_t queue_limit_;
+  uint64_t credit_ {};
+  uint64_t queued_bytes_ {};
+  std::deque<Queued> queue_ {};
+  std::deque<InFlight> wire_ {};
+
+  uint64_t drops_ {};
+  uint64_t packets_ {};
+  uint64_t queueing_delay_ {};
+};
+
+constexpr uint64_t HEADER_SIZE = 40; // IPv4 + TCP headers
+
+string name_of( TCPConfig::CongestionControl cc )
+{
+  switch ( cc ) {
+    case TCPConfig::CongestionControl::None:
+      return "none";
+    case TCPConfig::CongestionControl::Reno:
+      return "Reno";
+    case TCPConfig::CongestionControl::Cubic:
+      return "CUBIC";
+    case TCPConfig::CongestionControl::BBR:
+      return "BBR";
+  }
+  return "?";
+}
+
+void bottleneck_test( TCPConfig::CongestionControl cc, // NOLINT(bugprone-easily-swappable-parameters)
+                      const bool paced,
+                      const uint64_t transfer_bytes,
+                      const uint64_t bytes_per_ms,
+                      const uint64_t one_way_delay_ms,
+                      const uint64_t queue_limit )
+{
+  const string data = [&] {
+    default_random_engine rd { 1370 };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < transfer_bytes; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  TCPConfig cfg;
+  cfg.congestion_control = cc;
+  cfg.pacing = paced;
+  const string name = name_of( cc ) + ( paced ? " (paced)" : "" );
+  cfg.rt_timeout = 200;
+  TCPSender sender { ByteStream { transfer_bytes }, cfg };
+  TCPReceiver receiver { Reassembler { ByteStream { TCPConfig::DEFAULT_CAPACITY } } };
+  sender.writer().push( data );
+  sender.writer().close();
+
+  Link<TCPSenderMessage> forward { bytes_per_ms, one_way_delay_ms, queue_limit };
+  Link<TCPReceiverMessage> reverse { UINT64_MAX / 2, one_way_delay_ms, UINT64_MAX };
+
+  uint64_t now = 0;
+  uint64_t highest_sent = 0;
+  uint64_t segments_sent = 0;
+  uint64_t retransmissions = 0;
+  auto transmit = [&]( const TCPSenderMessage& msg ) {
+    ++segments_sent;
+    const uint64_t start = msg.seqno.unwrap( cfg.isn, highest_sent );
+    if ( start < highest_sent ) {
+      ++retransmissions;
+    }
+    highest_sent = max( highest_sent, start + msg.sequence_length() );
+    forward.send( msg, msg.sequence_length() + HEADER_SIZE, now );
+  };
+
+  string output;
+  output.reserve( transfer_bytes );
+  constexpr uint64_t time_limit_ms = 120'000;
+
+  sender.push( transmit );
+  while ( not receiver.reader().is_finished() ) {
+    if ( ++now > time_limit_ms ) {
+      throw runtime_error( name + ": transfer did not finish within " + to_string( time_limit_ms )
+                           + " ms of simulated time" );
+    }
+    forward.tick( now );
+    forward.deliver( now, [&]( const TCPSenderMessage& msg ) {
+      receiver.receive( msg );
+      reverse.send( receiver.send(), HEADER_SIZE, now );
+    } );
+    while ( receiver.reader().bytes_buffered() ) {
+      output += receiver.reader().peek();
+      receiver.reader().pop( output.size() - receiver.reader().bytes_popped() );
+    }
+    reverse.tick( now );
+    reverse.deliver( now, [&]( const TCPReceiverMessage& msg ) { sender.receive( msg ); } );
+    sender.push( transmit );
+    sender.tick( 1, transmit );
+  }
+
+  if ( output != data ) {
+    throw runtime_error( name + ": mismatch between data written and read" );
+  }
+
+  const double seconds = static_cast<double>( now ) / 1000;
+  const double goodput_mbps = static_cast<double>( transfer_bytes ) * 8 / seconds / 1e6;
+  const double link_mbps = static_cast<double>( bytes_per_ms ) * 8 / 1000;
+
+  ostringstream summary;
+  summary << fixed << setprecision( 2 ) << setw( 14 ) << name << ": " << goodput_mbps << " of "
+          << link_mbps << " Mbit/s, " << forward.drops() << " drops, " << retransmissions << " of "
+          << segments_sent << " segments retransmitted, mean queueing delay " << setprecision( 1 )
+          << forward.mean_queueing_delay() << " ms";
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+  cout << "Congestion control over a " << link_mbps << " Mbit/s, " << 2 * one_way_delay_ms
+       << " ms RTT bottleneck with a " << queue_limit << "-byte queue: " << summary.str() << "\n";
+  debug_output << "             " << summary.str() << "\n";
+}
+
+void program_body()
+{
+  // 10 Mbit/s and 40 ms RTT: a 50 kB bandwidth-delay product plus a 10 kB queue is less than the receiver's
+  // 64 kB window, so without congestion control the sender overruns the queue
+  for ( const auto cc : { TCPConfig::CongestionControl::None,
+                          TCPConfig::CongestionControl::Reno,
+                          TCPConfig::CongestionControl::Cubic,
+                          TCPConfig::CongestionControl::BBR } ) {
+    for ( const bool paced : { false, true } ) {
+      if ( paced and cc == TCPConfig::CongestionControl::None ) {
+        continue; // no rate to pace at
+      }
+      bottleneck_test( cc, paced, 4'000'000, 1250, 20, 10'000 );
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
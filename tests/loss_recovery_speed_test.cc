@@ -0,0 +1,193 @@
+#include "fd_adapter.hh"
+#include "lossy_fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// An in-memory stand-in for the TUN adapter: whatever is written comes out of read() after a fixed delay.
+// Wrapped in a LossyFdAdapter, it drops written segments at the configured uplink loss rate.
+class DelayAdapter : public FdAdapterBase
+{
+public:
+  DelayAdapter( uint64_t delay_ms, bool strip_sack ) : delay_ms_( delay_ms ), strip_sack_( strip_sack ) {}
+
+  optional<TCPMessage> read()
+  {
+    if ( wire_.empty() or wire_.front().second > now_ ) {
+      return {};
+    }
+    auto msg = move( wire_.front().first );
+    wire_.pop_front();
+    return msg;
+  }
+
+  void write( const TCPMessage& msg )
+  {
+    wire_.emplace_back( msg, now_ + delay_ms_ );
+    if ( strip_sack_ ) {
+      wire_.back().first.receiver.sack.clear(); // a peer that does not implement SACK
+    }
+  }
+
+  void tick( const size_t ms_since_last_tick ) { now_ += ms_since_last_tick; }
+
+private:
+  uint64_t delay_ms_;
+  bool strip_sack_;
+  uint64_t now_ {};
+  deque<pair<TCPMessage, uint64_t>> wire_ {};
+};
+
+struct Recovery
+{
+  string name;
+  bool fast_retransmit;
+  bool sack;
+  bool rack_tlp;
+};
+
+double transfer( const Recovery& recovery, const string& data, double loss_rate, uint64_t one_way_delay_ms )
+{
+  TCPConfig cfg;
+  cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+  cfg.adaptive_rto = true;
+  cfg.fast_retransmit = recovery.fast_retransmit;
+  cfg.rack_tlp = recovery.rack_tlp;
+
+  TCPPeer sender { cfg };
+  TCPPeer receiver { cfg };
+
+  LossyFdAdapter<DelayAdapter> forward { DelayAdapter { one_way_delay_ms, not recovery.sack } };
+  LossyFdAdapter<DelayAdapter> reverse { DelayAdapter { one_way_delay_ms, not recovery.sack } };
+  forward.config_mut().loss_rate_up
+    = static_cast<uint16_t>( loss_rate * static_cast<double>( numeric_limits<uint16_t>::max() ) );
+
+  auto to_receiver = [&]( const TCPMessage& msg ) { forward.write( msg ); };
+  auto to_sender = [&]( const TCPMessage& msg ) { reverse.write( msg ); };
+
+  string output;
+  output.reserve( data.size() );
+  size_t written = 0;
+  uint64_t now = 0;
+  constexpr uint64_t time_limit_ms = 600'000;
+
+  while ( not receiver.inbound_reader().is_finished() ) {
+    if ( ++now > time_limit_ms ) {
+      throw runtime_error( recovery.name + ": transfer did not finish within " + to_string( time_limit_ms )
+                           + " ms of simulated time" );
+    }
+
+    if ( written < data.size() ) {
+      const size_t len = min( data.size() - written, sender.outbound_writer().available_capacity() );
+      sender.outbound_writer().push( data.substr( written, len ) );
+      written += len;
+      if ( written == data.size() ) {
+        sender.outbound_writer().close();
+      }
+    }
+    sender.push( to_receiver );
+
+    while ( auto msg = forward.read() ) {
+      receiver.receive( move( msg.value() ), to_sender );
+    }
+    while ( receiver.inbound_reader().bytes_buffered() ) {
+      output += receiver.inbound_reader().peek();
+      receiver.inbound_reader().pop( output.size() - receiver.inbound_reader().bytes_popped() );
+    }
+    while ( auto msg = reverse.read() ) {
+      sender.receive( move( msg.value() ), to_receiver );
+    }
+
+    sender.tick( 1, to_receiver );
+    receiver.tick( 1, to_sender );
+    forward.tick( 1 );
+    reverse.tick( 1 );
+  }
+
+  if ( output != data ) {
+    throw runtime_error( recovery.name + ": mismatch between data written and read" );
+  }
+
+  return static_cast<double>( data.size() ) * 8 / ( static_cast<double>( now ) / 1000 ) / 1e6;
+}
+
+void program_body()
+{
+  constexpr size_t transfer_bytes = 1'000'000;
+  constexpr uint64_t one_way_delay_ms = 20;
+  constexpr unsigned runs = 10; // the loss pattern is random, so report the mean over several transfers
+
+  const string data = [&] {
+    default_random_engine rd { 1370 };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < transfer_bytes; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  const Recovery recoveries[] = { { "RTO only", false, false, false },
+                                  { "NewReno (duplicate ACKs)", true, false, false },
+                                  { "SACK scoreboard", false, true, false },
+                                  { "SACK + RACK-TLP", false, true, true } };
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+  cout << "Reno over a " << 2 * one_way_delay_ms
+       << " ms RTT path, mean goodput in Mbit/s by data-segment loss rate:\n";
+  debug_output << "\n";
+
+  ostringstream header;
+  header << setw( 26 ) << "";
+  for ( const double loss : { 0.0, 0.005, 0.01, 0.02, 0.05 } ) {
+    header << setw( 9 ) << fixed << setprecision( 1 ) << loss * 100 << "%";
+  }
+  cout << header.str() << "\n";
+  debug_output << header.str() << "\n";
+
+  for ( const auto& recovery : recoveries ) {
+    ostringstream row;
+    row << setw( 26 ) << recovery.name;
+    for ( const double loss : { 0.0, 0.005, 0.01, 0.02, 0.05 } ) {
+      double total = 0;
+      for ( unsigned run = 0; run < runs; ++run ) {
+        total += transfer( recovery, data, loss, one_way_delay_ms );
+      }
+      row << setw( 10 ) << fixed << setprecision( 2 ) << total / runs;
+    }
+    cout << row.str() << "\n";
+    debug_output << row.str() << "\n";
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
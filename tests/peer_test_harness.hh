@@ -0,0 +1,80 @@
+#pragma once
+
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Hand everything `from` sent to `to`, collecting what `to` sends in reply
+inline void deliver( std::vector<TCPMessage>& from, TCPPeer& to, std::vector<TCPMessage>& replies )
+{
+  auto transmit = [&]( const TCPMessage& msg ) { replies.push_back( msg ); };
+  for ( auto& msg : from ) {
+    to.receive( std::move( msg ), transmit );
+  }
+  from.clear();
+}
+
+// Two TCPPeers with the same config, connected by a handshake that `a` opens; what each sends is collected
+// in a_out and b_out until it is delivered
+struct Connection
+{
+  TCPConfig cfg {};
+  TCPPeer a { cfg };
+  TCPPeer b { cfg };
+  std::vector<TCPMessage> a_out {};
+  std::vector<TCPMessage> b_out {};
+
+  explicit Connection( const TCPConfig& config ) : cfg( config ), a( config ), b( config )
+  {
+    a.push( a_transmit() );
+    deliver( a_out, b, b_out );
+    deliver( b_out, a, a_out );
+    deliver( a_out, b, b_out );
+    if ( not b_out.empty() ) {
+      throw std::runtime_error( "the ACK of the SYN/ACK should not be answered" );
+    }
+  }
+
+  std::function<void( TCPMessage )> a_transmit()
+  {
+    return [this]( const TCPMessage& msg ) { a_out.push_back( msg ); };
+  }
+  std::function<void( TCPMessage )> b_transmit()
+  {
+    return [this]( const TCPMessage& msg ) { b_out.push_back( msg ); };
+  }
+
+  // Have `a` send `bytes` of data, returning the segments instead of delivering them
+  std::vector<TCPMessage> send_data( size_t bytes )
+  {
+    a.outbound_writer().push( std::string( bytes, 'x' ) );
+    a.push( a_transmit() );
+    return std::move( a_out );
+  }
+
+  // Deliver in both directions until neither peer has anything more to say
+  void settle()
+  {
+    while ( not a_out.empty() or not b_out.empty() ) {
+      std::vector<TCPMessage> to_b = std::move( a_out );
+      std::vector<TCPMessage> to_a = std::move( b_out );
+      a_out.clear();
+      b_out.clear();
+      deliver( to_b, b, b_out );
+      deliver( to_a, a, a_out );
+    }
+  }
+
+  void tick( uint64_t ms )
+  {
+    a.tick( ms, a_transmit() );
+    b.tick( ms, b_transmit() );
+  }
+};
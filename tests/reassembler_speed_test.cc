@@ -13,9 +13,56 @@
 using namespace std;
 using namespace std::chrono;
 
+enum class Workload
+{
+  InOrder,       // every segment starts exactly where the previous one ended
+  Overlapping,   // each segment overlaps its neighbours and arrives slightly out of order
+  DuplicateHeavy // a segment beyond a hole, a duplicate of it, the hole itself, then a stale retransmission
+};
+
+queue<tuple<uint64_t, string, bool>> split( const string& data, const size_t capacity, const Workload workload )
+{
+  queue<tuple<uint64_t, string, bool>> split_data;
+  switch ( workload ) {
+    case Workload::InOrder:
+      for ( size_t i = 0; i < data.size(); i += capacity / 2 ) {
+        split_data.emplace( i, data.substr( i, capacity / 2 ), i + capacity / 2 >= data.size() );
+      }
+      break;
+
+    case Workload::Overlapping:
+      for ( size_t i = 0; i < data.size(); i += capacity ) {
+        split_data.emplace( i + 2, data.substr( i + 2, capacity * 2 ), i + 2 + capacity * 2 >= data.size() );
+        split_data.emplace( i, data.substr( i, capacity * 2 ), i + capacity * 2 >= data.size() );
+        split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
+      }
+      break;
+
+    case Workload::DuplicateHeavy: {
+      const size_t segment = capacity / 4;
+      auto emit = [&]( size_t index ) {
+        split_data.emplace( index, data.substr( index, segment ), index + segment >= data.size() );
+      };
+      for ( size_t i = 0; i < data.size(); i += 2 * segment ) {
+        if ( i + segment < data.size() ) {
+          emit( i + segment );
+          emit( i + segment );
+        }
+        emit( i );
+        if ( i >= segment ) {
+          emit( i - segment );
+        }
+      }
+      break;
+    }
+  }
+  return split_data;
+}
+
 void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const Workload workload )
 {
   // Generate the data to be written
   const string data = [&] {
@@ -29,12 +76,7 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   }();
 
   // Split the data into segments before writing
-  queue<tuple<uint64_t, string, bool>> split_data;
-  for ( size_t i = 0; i < data.size(); i += capacity ) {
-    split_data.emplace( i + 2, data.substr( i + 2, capacity * 2 ), i + 2 + capacity * 2 >= data.size() );
-    split_data.emplace( i, data.substr( i, capacity * 2 ), i + capacity * 2 >= data.size() );
-    split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
-  }
+  auto split_data = split( data, capacity, workload );
 
   Reassembler reassembler { ByteStream { capacity } };
 
@@ -71,11 +113,15 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  const string name = workload == Workload::InOrder       ? "in-order"
+                      : workload == Workload::Overlapping ? "overlapping"
+                                                          : "duplicate-heavy";
+
+  cout << "Reassembler (" << name << ") to ByteStream with capacity=" << capacity << " reached " << fixed
+       << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
 
-  debug_output << "             Reassembler throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
-               << " Gbit/s\n";
+  debug_output << "             Reassembler throughput (" << name << "): " << fixed << setprecision( 2 )
+               << gigabits_per_second << " Gbit/s\n";
 
   if ( gigabits_per_second < 0.1 ) {
     throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
@@ -84,7 +130,9 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
 
 void program_body()
 {
-  speed_test( 10000, 1500, 1370 );
+  speed_test( 10000, 1500, 1369, Workload::InOrder );
+  speed_test( 10000, 1500, 1370, Workload::Overlapping );
+  speed_test( 10000, 1500, 1371, Workload::DuplicateHeavy );
 }
 
 int main()
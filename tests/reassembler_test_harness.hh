@@ -7,6 +7,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<ByteStream>> T>
 struct ReassemblerTestStep : public TestStep<Reassembler>
@@ -49,6 +50,36 @@ struct BytesPending : public ConstExpectNumber<Reassembler, uint64_t>
   uint64_t value( const Reassembler& r ) const override { return r.bytes_pending(); }
 };
 
+struct BufferedRanges : public Expectation<Reassembler>
+{
+  std::vector<std::pair<uint64_t, uint64_t>> ranges_;
+
+  explicit BufferedRanges( std::vector<std::pair<uint64_t, uint64_t>> ranges ) : ranges_( std::move( ranges ) ) {}
+
+  static std::string format( const std::vector<std::pair<uint64_t, uint64_t>>& ranges )
+  {
+    std::ostringstream ss;
+    ss << "{";
+    for ( const auto& [first, last] : ranges ) {
+      ss << " [" << first << ", " << last << ")";
+    }
+    ss << " }";
+    return ss.str();
+  }
+
+  std::string description() const override { return "buffered_ranges = " + format( ranges_ ); }
+
+  void execute( Reassembler& r ) const override { execute( std::as_const( r ) ); }
+  void execute( const Reassembler& r ) const
+  {
+    const auto got = r.buffered_ranges();
+    if ( got != ranges_ ) {
+      throw ExpectationViolation { "The Reassembler should have had buffered_ranges = " + format( ranges_ )
+                                   + ", but instead it was " + format( got ) + "." };
+    }
+  }
+};
+
 struct Insert : public Action<Reassembler>
 {
   std::string data_;
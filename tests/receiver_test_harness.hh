@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<Reassembler>> T>
 struct DirectReassemblerTest : public TestStep<TCPReceiver>
@@ -61,11 +62,11 @@ public:
   using TestHarness<TCPReceiver>::execute;
 };
 
-struct ExpectWindow : public ExpectNumber<TCPReceiver, uint16_t>
+struct ExpectWindow : public ExpectNumber<TCPReceiver, uint32_t>
 {
   using ExpectNumber::ExpectNumber;
   std::string name() const override { return "window_size"; }
-  uint16_t value( TCPReceiver& rs ) const override { return rs.send().window_size; }
+  uint32_t value( TCPReceiver& rs ) const override { return rs.send().window_size; }
 };
 
 struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
@@ -75,6 +76,47 @@ struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
   std::optional<Wrap32> value( TCPReceiver& rs ) const override { return rs.send().ackno; }
 };
 
+struct ExpectSack : public Expectation<TCPReceiver>
+{
+  std::vector<SACKBlock> blocks_ {};
+
+  explicit ExpectSack( const std::vector<std::pair<uint32_t, uint32_t>>& blocks )
+  {
+    for ( const auto& [left, right] : blocks ) {
+      blocks_.push_back( { Wrap32 { left }, Wrap32 { right } } );
+    }
+  }
+
+  static std::string format( const std::vector<SACKBlock>& blocks )
+  {
+    std::ostringstream ss;
+    ss << "{";
+    for ( const auto& block : blocks ) {
+      ss << " [" << block.left << ", " << block.right << ")";
+    }
+    ss << " }";
+    return ss.str();
+  }
+
+  std::string description() const override { return "SACK blocks = " + format( blocks_ ); }
+
+  void execute( TCPReceiver& rs ) const override
+  {
+    const auto got = rs.send().sack;
+    if ( got != blocks_ ) {
+      throw ExpectationViolation { "The TCPReceiver should have sent SACK blocks " + format( blocks_ )
+                                   + ", but instead it sent " + format( got ) + "." };
+    }
+  }
+};
+
+struct ExpectTimestampEcho : public ExpectNumber<TCPReceiver, std::optional<uint32_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "timestamp_echo"; }
+  std::optional<uint32_t> value( TCPReceiver& rs ) const override { return rs.send().timestamp_echo; }
+};
+
 struct ExpectReset : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
@@ -118,6 +160,36 @@ struct HasAckno : public ExpectBool<TCPReceiver>
   bool value( TCPReceiver& rs ) const override { return rs.send().ackno.has_value(); }
 };
 
+struct SetMaxCapacity : public Action<TCPReceiver>
+{
+  size_t max_capacity_;
+
+  explicit SetMaxCapacity( size_t max_capacity ) : max_capacity_( max_capacity ) {}
+  std::string description() const override { return "set_max_capacity( " + std::to_string( max_capacity_ ) + " )"; }
+  void execute( TCPReceiver& rs ) const override { rs.set_max_capacity( max_capacity_ ); }
+};
+
+struct AckSent : public Action<TCPReceiver>
+{
+  std::string description() const override { return "ack_sent"; }
+  void execute( TCPReceiver& rs ) const override { rs.ack_sent(); }
+};
+
+struct Autotune : public Action<TCPReceiver>
+{
+  uint64_t now_ms_;
+  std::optional<uint64_t> rtt_ms_;
+
+  explicit Autotune( uint64_t now_ms, std::optional<uint64_t> rtt_ms = {} ) : now_ms_( now_ms ), rtt_ms_( rtt_ms )
+  {}
+  std::string description() const override
+  {
+    return "autotune at " + std::to_string( now_ms_ ) + " ms"
+           + ( rtt_ms_.has_value() ? " with an RTT sample of " + std::to_string( rtt_ms_.value() ) + " ms" : "" );
+  }
+  void execute( TCPReceiver& rs ) const override { rs.autotune( now_ms_, rtt_ms_ ); }
+};
+
 struct SegmentArrives : public Action<TCPReceiver>
 {
   TCPSenderMessage msg_ {};
@@ -155,6 +227,12 @@ struct SegmentArrives : public Action<TCPReceiver>
     return *this;
   }
 
+  SegmentArrives& with_timestamp( uint32_t tsval )
+  {
+    msg_.timestamp = tsval;
+    return *this;
+  }
+
   SegmentArrives& without_ackno()
   {
     ackno_expected_ = HasAckno { false };
@@ -181,6 +259,9 @@ struct SegmentArrives : public Action<TCPReceiver>
     if ( msg_.FIN ) {
       ss << " +FIN";
     }
+    if ( msg_.timestamp.has_value() ) {
+      ss << " TSval=" << msg_.timestamp.value();
+    }
     ss << ")";
 
     if ( ackno_expected_.value_ ) {
@@ -0,0 +1,103 @@
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      const size_t cap = 4000;
+      const uint32_t isn = 34012;
+      TCPReceiverTestHarness test { "window grows to twice what the application reads per RTT", cap };
+      test.execute( SetMaxCapacity { 50000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 4000, 'a' ) ) );
+      test.execute( ReadAll { string( 4000, 'a' ) } );
+      test.execute( Autotune { 0, 100 } );
+      test.execute( ExpectWindow { cap } );
+
+      // not a full RTT yet
+      test.execute( SegmentArrives {}.with_seqno( isn + 4001 ).with_data( string( 4000, 'b' ) ) );
+      test.execute( ReadAll { string( 4000, 'b' ) } );
+      test.execute( Autotune { 99, 100 } );
+      test.execute( ExpectWindow { cap } );
+
+      // 8000 bytes read in one RTT
+      test.execute( Autotune { 100, 100 } );
+      test.execute( ExpectWindow { 16000 } );
+
+      // a slow reader does not make the window grow
+      test.execute( SegmentArrives {}.with_seqno( isn + 8001 ).with_data( string( 1000, 'c' ) ) );
+      test.execute( ReadAll { string( 1000, 'c' ) } );
+      test.execute( Autotune { 200, 100 } );
+      test.execute( ExpectWindow { 16000 } );
+
+      // nor grows past the ceiling
+      test.execute( SegmentArrives {}.with_seqno( isn + 9001 ).with_data( string( 16000, 'd' ) ) );
+      test.execute( ReadAll { string( 16000, 'd' ) } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 25001 ).with_data( string( 16000, 'e' ) ) );
+      test.execute( ReadAll { string( 16000, 'e' ) } );
+      test.execute( Autotune { 300, 100 } );
+      test.execute( ExpectWindow { 50000 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 41001 ).with_data( string( 50000, 'f' ) ) );
+      test.execute( ExpectWindow { 0 } );
+      test.execute( ReadAll { string( 50000, 'f' ) } );
+      test.execute( Autotune { 400, 100 } );
+      test.execute( ExpectWindow { 50000 } );
+    }
+
+    {
+      const size_t cap = 4000;
+      const uint32_t isn = 5;
+      TCPReceiverTestHarness test { "window stays fixed without a ceiling", cap };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + 4000 * i ).with_data( string( 4000, 'x' ) ) );
+        test.execute( ReadAll { string( 4000, 'x' ) } );
+        test.execute( Autotune { 100ULL * i, 100 } );
+      }
+      test.execute( ExpectWindow { cap } );
+    }
+
+    {
+      const size_t cap = 1000;
+      const uint32_t isn = 90210;
+      TCPReceiverTestHarness test { "without timestamps, the RTT is the time to fill a window", cap };
+      test.execute( SetMaxCapacity { 10000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 1000, 'a' ) ) );
+      test.execute( ReadAll { string( 1000, 'a' ) } );
+      test.execute( Autotune { 0 } );
+      test.execute( ExpectWindow { cap } );
+
+      // the window advertised at 0 ms is filled at 50 ms
+      test.execute( SegmentArrives {}.with_seqno( isn + 1001 ).with_data( string( 1000, 'b' ) ) );
+      test.execute( ReadAll { string( 1000, 'b' ) } );
+      test.execute( Autotune { 50 } );
+      test.execute( ExpectWindow { 4000 } );
+    }
+
+    {
+      const size_t cap = 60000;
+      const uint32_t isn = 777;
+      TCPReceiverTestHarness test { "without window scaling the window stops at 65535", cap };
+      test.execute( SetMaxCapacity { 1'000'000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 60000, 'a' ) ) );
+      test.execute( ReadAll { string( 60000, 'a' ) } );
+      test.execute( Autotune { 10, 10 } );
+      test.execute( ExpectWindow { UINT16_MAX } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no SACK blocks without holes", 4000 };
+      test.execute( ExpectSack { {} } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectSack { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectSack { {} } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "one hole", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( BufferedRanges { { { 4, 8 } } } );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSack { { { isn + 5, isn + 9 } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ij" ) );
+      test.execute( BufferedRanges { { { 4, 10 } } } );
+      test.execute( ExpectSack { { { isn + 5, isn + 11 } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( BufferedRanges { {} } );
+      test.execute( ExpectAckno { Wrap32 { isn + 11 } } );
+      test.execute( ExpectSack { {} } );
+      test.execute( ReadAll { "abcdefghij" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "most recent block first", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "c" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "g" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "e" ) );
+      test.execute( BufferedRanges { { { 2, 3 }, { 4, 5 }, { 6, 7 } } } );
+      test.execute( ExpectSack { { { isn + 5, isn + 6 }, { isn + 3, isn + 4 }, { isn + 7, isn + 8 } } } );
+
+      // a duplicate moves its block back to the front
+      test.execute( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "g" ) );
+      test.execute( ExpectSack { { { isn + 7, isn + 8 }, { isn + 3, isn + 4 }, { isn + 5, isn + 6 } } } );
+
+      // the block that fills a hole is reported merged with its neighbours
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "d" ) );
+      test.execute( ExpectSack { { { isn + 3, isn + 6 }, { isn + 7, isn + 8 } } } );
+
+      // an in-order segment is not in any block
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "a" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 2 } } );
+      test.execute( ExpectSack { { { isn + 3, isn + 6 }, { isn + 7, isn + 8 } } } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "at most four blocks", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint32_t i = 0; i < 6; i++ ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 2 + 2 * i ).with_data( "x" ) );
+      }
+      test.execute( BytesPending { 6 } );
+      test.execute( ExpectSack {
+        { { isn + 12, isn + 13 }, { isn + 2, isn + 3 }, { isn + 4, isn + 5 }, { isn + 6, isn + 7 } } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
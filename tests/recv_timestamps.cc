@@ -0,0 +1,116 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "echo the timestamp of the segment at the ackno", 4000 };
+      test.execute( ExpectTimestampEcho { optional<uint32_t> {} } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( 10 ) );
+      test.execute( ExpectTimestampEcho { 10U } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_timestamp( 20 ) );
+      test.execute( ExpectTimestampEcho { 20U } );
+
+      // an out-of-order segment leaves the echo alone, so the sender's RTT sample includes the wait for the hole
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ij" ).with_timestamp( 30 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectTimestampEcho { 20U } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_timestamp( 40 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 11 } } );
+      test.execute( ExpectTimestampEcho { 40U } );
+
+      // a duplicate entirely left of the window is not acceptable and leaves it alone (RFC 7323 4.3)
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_timestamp( 50 ) );
+      test.execute( ExpectTimestampEcho { 40U } );
+
+      // a retransmission that reaches into the window still refreshes it
+      test.execute( SegmentArrives {}.with_seqno( isn + 10 ).with_data( "jk" ).with_timestamp( 60 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 12 } } );
+      test.execute( ExpectTimestampEcho { 60U } );
+      test.execute( ReadAll { "abcdefghijk" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "a segment beyond the window does not move the echo", 4 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( 10 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_timestamp( 20 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectTimestampEcho { 10U } );
+
+      // with the window full, only a zero-length segment at the ackno is acceptable
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_timestamp( 30 ) );
+      test.execute( ExpectTimestampEcho { 30U } );
+      test.execute( ExpectWindow { 0 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "e" ).with_timestamp( 40 ) );
+      test.execute( ExpectTimestampEcho { 30U } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_timestamp( 50 ) );
+      test.execute( ExpectTimestampEcho { 50U } );
+      test.execute( ReadAll { "abcd" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "PAWS drops segments with old timestamps", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( UINT32_MAX - 10 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ).with_timestamp( UINT32_MAX ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+
+      // a segment from before the last accepted timestamp is dropped even though its seqno looks in-window
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "old" ).with_timestamp( UINT32_MAX - 5 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( BytesPending { 0 } );
+      test.execute( ExpectTimestampEcho { UINT32_MAX } );
+
+      // timestamps compare modulo 2^32, so a clock that wrapped is still newer
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "def" ).with_timestamp( 5 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 7 } } );
+      test.execute( ExpectTimestampEcho { 5U } );
+      test.execute( ReadAll { "abcdef" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "a delayed ACK echoes the timestamp of the first segment it covers", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( 10 ) );
+      test.execute( AckSent {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_timestamp( 20 ) );
+      test.execute( ExpectTimestampEcho { 20U } );
+
+      // not acknowledged yet, so the next in-order segment is beyond the last ackno sent
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_timestamp( 30 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      test.execute( ExpectTimestampEcho { 20U } );
+      test.execute( AckSent {} );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ).with_timestamp( 40 ) );
+      test.execute( ExpectTimestampEcho { 40U } );
+      test.execute( ReadAll { "abcdefghijkl" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no echo without timestamps", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ) );
+      test.execute( ExpectTimestampEcho { optional<uint32_t> {} } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
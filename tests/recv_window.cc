@@ -105,6 +105,32 @@ int main()
       test.execute( BytesPending( 0 ) );
     }
 
+    {
+      const size_t cap = 1'000'000;
+      const uint32_t isn = 8437;
+      TCPReceiverTestHarness test { "no bytes beyond the advertised window with a large stream capacity", cap };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindow { UINT16_MAX } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( UINT16_MAX, 'x' ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 + UINT16_MAX } } );
+      test.execute( ExpectWindow { 0 } );
+
+      // a one-byte zero-window probe, and data or a FIN past the right edge, are not taken
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 + UINT16_MAX ).with_data( "y" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 2 + UINT16_MAX ).with_data( "z" ).with_fin() );
+      test.execute( BytesPushed { UINT16_MAX } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 + UINT16_MAX } } );
+      test.execute( ExpectWindow { 0 } );
+
+      // a segment straddling the right edge is trimmed to the window
+      test.execute( ReadAll { string( UINT16_MAX, 'x' ) } );
+      test.execute( ExpectWindow { UINT16_MAX } );
+      test.execute(
+        SegmentArrives {}.with_seqno( isn + 1 + UINT16_MAX ).with_data( string( UINT16_MAX + 10, 'y' ) ) );
+      test.execute( BytesPushed { 2UL * UINT16_MAX } );
+      test.execute( ExpectWindow { 0 } );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
@@ -90,6 +90,34 @@ int main()
       test.execute( AckReceived { Wrap32 { isn + 2 } }.with_win( 1000 ) );
       test.execute( ExpectSeqnosInFlight { 2 } );
     }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.send_capacity = 4;
+
+      TCPSenderTestHarness test { "Unacknowledged bytes keep their place in the outbound stream", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abcd" } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ) );
+      test.execute( Push { "e" } );
+      test.execute( ExpectNoSegment {} );
+
+      // a partial ACK frees nothing: the whole segment may still need to be retransmitted
+      test.execute( AckReceived { Wrap32 { isn + 3 } } );
+      test.execute( Push { "e" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+
+      test.execute( AckReceived { Wrap32 { isn + 5 } } );
+      test.execute( Push { "efghi" } );
+      test.execute( ExpectMessage {}.with_data( "efgh" ).with_seqno( isn + 5 ) );
+      test.execute( ExpectNoSegment {} );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
@@ -0,0 +1,161 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+      cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+      cfg.initial_window = 4;
+
+      TCPSenderTestHarness test { "Reno slow start, then one segment after a timeout", cfg };
+      test.execute( ExpectCongestionWindow { 4000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 4000 } );
+
+      // the receiver's window is much larger, but only the initial window goes out
+      test.execute( Push { string( 6000, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 4000 } );
+
+      // slow start: the window grows by what was acknowledged, at most two segments per ACK
+      test.execute( AckReceived { Wrap32 { isn + 2001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 6000 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 4001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 5001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( Tick { retx_timeout } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2001 ) );
+      test.execute( ExpectCongestionWindow { 1000 } );
+      test.execute( AckReceived { Wrap32 { isn + 6001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 3000 } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+      cfg.initial_window = 4;
+
+      TCPSenderTestHarness test { "Reno halves the window once per loss detected by SACK", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 4000, 'x' ) } );
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ).with_sack( isn + 1001, isn + 4001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 2000 } );
+
+      // SACKed segments have left the network: one more segment fits in the halved window
+      test.execute( Push { string( 3000, 'y' ) } );
+      test.execute( ExpectMessage {}.with_data( string( 1000, 'y' ) ).with_seqno( isn + 4001 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // recovery ends and congestion avoidance adds one segment per window acknowledged
+      test.execute( AckReceived { Wrap32 { isn + 5001 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 3000 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 5001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 6001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+      TCPSenderTestHarness test { "The first flight after the handshake is ten segments", cfg };
+      test.execute( ExpectCongestionWindow { 10000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 12000, 'x' ) } );
+      for ( uint32_t i = 0; i < 10; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 + 1000 * i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 10000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = TCPConfig::CongestionControl::Cubic;
+
+      TCPSenderTestHarness test { "The initial window follows the MSS learned from the SYN", cfg };
+      test.execute( SetPeerMSS { 536 } );
+      test.execute( ExpectCongestionWindow { 5360 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 5360 } );
+
+      // a later SYN (say, a retransmitted one) no longer resets the window
+      test.execute( Push { string( 6000, 'x' ) } );
+      for ( uint32_t i = 0; i < 10; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 536 ).with_seqno( isn + 1 + 536 * i ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( SetPeerMSS { 536 } );
+      test.execute( ExpectCongestionWindow { 5360 } );
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.congestion_control = TCPConfig::CongestionControl::BBR;
+      cfg.mss = 9000;
+
+      // RFC 6928 caps the initial window at 14600 bytes, but never below two segments
+      TCPSenderTestHarness test { "Large segments cap the initial window in bytes", cfg };
+      test.execute( ExpectCongestionWindow { 18000 } );
+      test.execute( SetPeerMSS { 1460 } );
+      test.execute( ExpectCongestionWindow { 14600 } );
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+      cfg.initial_window = 4;
+
+      TCPSenderTestHarness test { "The initial window is configurable", cfg };
+      test.execute( ExpectCongestionWindow { 4000 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.mss = 4000;
+
+      TCPSenderTestHarness test { "Without probing, the configured MSS is used from the start", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 10000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 4000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 4000 ).with_seqno( isn + 4001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 2000 ).with_seqno( isn + 8001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.mss = 4000;
+      cfg.mtu_probing = true;
+
+      TCPSenderTestHarness test { "Each acknowledged probe raises the MSS halfway to the limit", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+
+      // one probe of (1000 + 4000) / 2 bytes at a time; everything else uses the MSS that is known to work
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 2500 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 2501 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 3501 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 4501 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 5001 } }.with_win( 60000 ) );
+
+      test.execute( Push { string( 6000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 3250 ).with_seqno( isn + 5001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 2500 ).with_seqno( isn + 8251 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 250 ).with_seqno( isn + 10751 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+      cfg.mss = 4000;
+      cfg.mtu_probing = true;
+      cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+      cfg.initial_window = 4;
+
+      TCPSenderTestHarness test { "A lost probe is resent in MSS-sized pieces and is not congestion", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 4000 } );
+      test.execute( Push { string( 2500, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 2500 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( Tick { retx_timeout } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 2001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 4000 } );
+      test.execute( AckReceived { Wrap32 { isn + 2501 } }.with_win( 60000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+
+      // the MSS did not grow: the next segment is another probe of the same size
+      test.execute( Push { string( 2500, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 2500 ).with_seqno( isn + 2501 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+      cfg.mss = 4000;
+      cfg.mtu_probing = true;
+
+      TCPSenderTestHarness test { "After MAX_PROBES losses a smaller probe is tried", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      uint32_t next = 1;
+      for ( size_t i = 0; i < TCPConfig::MAX_PROBES; i++ ) {
+        test.execute( Push { string( 2500, 'x' ) } );
+        test.execute( ExpectMessage {}.with_payload_size( 2500 ).with_seqno( isn + next ) );
+        test.execute( Tick { retx_timeout } );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + next ) );
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + next + 1000 ) );
+        test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + next + 2000 ) );
+        next += 2500;
+        test.execute( AckReceived { Wrap32 { isn + next } }.with_win( 60000 ) );
+      }
+
+      // 2500 bytes does not fit through the path: search between 1000 and 2499
+      test.execute( Push { string( 2500, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1750 ).with_seqno( isn + next ) );
+      test.execute( ExpectMessage {}.with_payload_size( 750 ).with_seqno( isn + next + 1750 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
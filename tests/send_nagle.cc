@@ -0,0 +1,141 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.nagle = true;
+
+      TCPSenderTestHarness test { "Nagle holds small writes while data is unacknowledged", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+
+      // nothing is in flight, so the first small write goes out at once
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( Push { "b" } );
+      test.execute( Push { "c" } );
+      test.execute( Push { "d" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 1 } );
+
+      // the ACK releases everything written meanwhile as one segment
+      test.execute( AckReceived { Wrap32 { isn + 2 } }.with_win( 1000 ) );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_data( "bcd" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // closing the stream sends the rest with the FIN, without waiting
+      test.execute( Push { "e" }.with_close() );
+      test.execute( ExpectMessage {}.with_data( "e" ).with_seqno( isn + 5 ).with_fin( true ) );
+      test.execute( ExpectSeqnosInFlight { 5 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.nagle = true;
+      cfg.mss = 4;
+
+      TCPSenderTestHarness test { "Nagle sends full segments and holds only the tail", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( Push { "bcdefghij" } );
+      test.execute( ExpectMessage {}.with_data( "bcde" ) );
+      test.execute( ExpectMessage {}.with_data( "fghi" ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 10 } }.with_win( 1000 ) );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_data( "j" ).with_seqno( isn + 10 ) );
+
+      // an explicit flush sends held data at once
+      test.execute( Push { "k" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Flush {} );
+      test.execute( ExpectMessage {}.with_data( "k" ).with_seqno( isn + 11 ) );
+      test.execute( ExpectSeqnosInFlight { 2 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      // shorter than the RTO, so that no retransmission comes before the corked data
+      const uint16_t cork_timeout = uniform_int_distribution<uint16_t> { 10, TCPConfig::TIMEOUT_DFLT - 1 }( rd );
+      cfg.isn = isn;
+      cfg.cork = true;
+      cfg.cork_timeout = cork_timeout;
+      cfg.mss = 4;
+
+      TCPSenderTestHarness test { "Cork holds small writes until a flush or the timer", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+
+      // held even with nothing in flight
+      test.execute( Push { "ab" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( Push { "c" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Flush {} );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // a full segment goes out, and the timer (started by the first held byte) releases the rest
+      test.execute( Push { "de" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { cork_timeout - 1U } );
+      test.execute( Push { "fghi" } );
+      test.execute( ExpectMessage {}.with_data( "defg" ).with_seqno( isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "hi" ).with_seqno( isn + 8 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 10 } }.with_win( 1000 ) );
+      test.execute( Tick { 10UL * cork_timeout } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Small writes are not held by default", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      for ( const string data : { "a", "b", "c" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      test.execute( ExpectSeqnosInFlight { 3 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
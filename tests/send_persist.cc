@@ -0,0 +1,117 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      // small enough that the backoff below stays under MAX_RTO_DFLT
+      const uint16_t rto = uniform_int_distribution<uint16_t> { 30, TCPConfig::MAX_RTO_DFLT / 8 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = rto;
+      cfg.persist_timer = true;
+
+      TCPSenderTestHarness test { "A zero window is probed with exponential backoff until it opens", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 0 ) );
+      test.execute( Push( "abc" ).with_close() );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+
+      // each probe reuses an acknowledged sequence number, so it is not data and not a retransmission
+      for ( const uint64_t interval : { 1, 2, 4, 8 } ) {
+        test.execute( Tick { interval * rto - 1 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( 0 ).with_seqno( isn ) );
+        test.execute( ExpectNoSegment {} );
+        test.execute( ExpectSeqnosInFlight { 0 } );
+        test.execute( ExpectConsecutiveRetransmissions { 0 } );
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 0 ) );
+        test.execute( ExpectNoSegment {} );
+      }
+
+      // the window update stops the persist timer
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 10 ) );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ).with_fin( true ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 0 ) );
+      test.execute( Tick { 100UL * rto } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t rto = uniform_int_distribution<uint16_t> { 30, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = rto;
+      cfg.persist_timer = true;
+
+      TCPSenderTestHarness test { "A window that closes after data is acknowledged starts the persist timer", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 3 ) );
+      test.execute( Push( "abcdef" ) );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { rto - 1U } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_win( 0 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the persist timer starts from the RTO when the window closes
+      test.execute( Tick { rto - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( 0 ).with_seqno( isn + 3 ) );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_win( 3 ) );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t rto = uniform_int_distribution<uint16_t> { 30, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = rto;
+      cfg.persist_timer = true;
+
+      TCPSenderTestHarness test { "Data in flight when the window closes is retransmitted with backoff", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 2 ) );
+      test.execute( Push( "abcd" ) );
+      test.execute( ExpectMessage {}.with_data( "ab" ).with_seqno( isn + 1 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 0 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( Tick { rto } );
+      test.execute( ExpectMessage {}.with_data( "ab" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectConsecutiveRetransmissions { 1 } );
+      test.execute( Tick { 2UL * rto - 1 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "ab" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectConsecutiveRetransmissions { 2 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
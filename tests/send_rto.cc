@@ -0,0 +1,168 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rt_timeout = 1000;
+      cfg.adaptive_rto = true;
+
+      TCPSenderTestHarness test { "RTO follows SRTT and RTTVAR", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( ExpectSmoothedRTT { 0 } );
+
+      // first sample: SRTT = R, RTTVAR = R/2, RTO = SRTT + 4 * RTTVAR
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTTVariation { 50 } );
+      test.execute( ExpectRTO { 300 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 299 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 599 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+
+      // Karn's rule: the ACK of a retransmitted segment is not an RTT sample, but it ends the backoff
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTO { 300 } );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+
+      test.execute( Push { "d" } );
+      test.execute( ExpectMessage {}.with_data( "d" ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 5 } } );
+      test.execute( ExpectSmoothedRTT { 90 } );
+      test.execute( ExpectRTTVariation { 57 } );
+      test.execute( ExpectRTO { 320 } );
+
+      test.execute( Push { "e" } );
+      test.execute( ExpectMessage {}.with_data( "e" ) );
+      test.execute( Tick { 319 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "e" ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rt_timeout = 1000;
+      cfg.adaptive_rto = true;
+
+      TCPSenderTestHarness test { "Echoed timestamps give RTT samples for retransmitted data", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_timestamp( 0 ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_timestamp_echo( 0 ) );
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTO { 300 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 100 ) );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 400 ) );
+
+      // the echo says the retransmission was acknowledged, 40 ms after it was sent
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_timestamp_echo( 400 ) );
+      test.execute( ExpectSmoothedRTT { 92 } );
+      test.execute( ExpectRTTVariation { 52 } );
+      test.execute( ExpectRTO { 302 } );
+
+      // an ACK that acknowledges nothing new is not a sample
+      test.execute( Tick { 500 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_timestamp_echo( 400 ) );
+      test.execute( ExpectSmoothedRTT { 92 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.adaptive_rto = true;
+      cfg.max_rto = 1000;
+
+      TCPSenderTestHarness test { "RTO is clamped to [min_rto, max_rto]", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 2 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSmoothedRTT { 2 } );
+      test.execute( ExpectRTO { TCPConfig::MIN_RTO_DFLT } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      for ( const uint64_t timeout : { 200, 400, 800, 1000, 1000 } ) {
+        test.execute( Tick { timeout - 1 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        test.execute( ExpectMessage {}.with_data( "abc" ) );
+      }
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.adaptive_rto = true;
+      cfg.rt_timeout = 100;
+
+      TCPSenderTestHarness test { "initial RTO is clamped to min_rto", cfg };
+      test.execute( ExpectRTO { TCPConfig::MIN_RTO_DFLT } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { TCPConfig::MIN_RTO_DFLT - 1 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.min_rto = 500;
+      cfg.max_rto = 400;
+      bool threw = false;
+      try {
+        const TCPSender sender { ByteStream { TCPConfig::DEFAULT_CAPACITY }, cfg };
+      } catch ( const invalid_argument& ) {
+        threw = true;
+      }
+      if ( not threw ) {
+        throw runtime_error( "a TCPConfig with min_rto > max_rto should be rejected" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      TCPSenderTestHarness test { "Retransmit the holes reported by SACK", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      for ( const string data : { "a", "b", "c", "d", "e", "f" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 6 } );
+
+      // one segment SACKed above the holes is not yet evidence of loss
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_sack( isn + 3, isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // three are: both holes below them are retransmitted at once, without waiting for the RTO
+      test.execute(
+        AckReceived { Wrap32 { isn + 1 } }.with_sack( isn + 5, isn + 7 ).with_sack( isn + 3, isn + 4 ) );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 6 } );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+
+      // the same SACK information does not trigger a second retransmission
+      test.execute(
+        AckReceived { Wrap32 { isn + 1 } }.with_sack( isn + 5, isn + 7 ).with_sack( isn + 3, isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // "d" has only two SACKed segments above it, so only the timer repairs it
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_sack( isn + 5, isn + 7 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 3 } );
+      test.execute( Tick { retx_timeout - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "d" ).with_seqno( isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 7 } } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( Tick { 4UL * retx_timeout } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Ignore SACK blocks outside what was sent", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }
+                      .with_sack( isn + 10, isn + 20 )
+                      .with_sack( isn + 30, isn + 40 )
+                      .with_sack( isn + 50, isn + 60 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 3 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
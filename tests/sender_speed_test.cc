@@ -0,0 +1,114 @@
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+// Push data through a TCPSender whose peer acknowledges every segment at once with a window that never closes,
+// so the time is spent building and sending segments
+void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t write_size,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const ByteStream::Mode mode = ByteStream::Mode::Ring )
+{
+  // Generate the data to be written
+  const string data = [&random_seed, &input_len] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  // Split the data into segments before writing
+  queue<string> split_data;
+  for ( size_t i = 0; i < data.size(); i += write_size ) {
+    split_data.emplace( data.substr( i, write_size ) );
+  }
+
+  TCPConfig cfg;
+  TCPSender sender { ByteStream { capacity, mode }, cfg };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  TCPReceiverMessage ack;
+  ack.window_size = static_cast<uint32_t>( capacity );
+  uint64_t segments = 0;
+  auto transmit = [&]( const TCPSenderMessage& msg ) {
+    ++segments;
+    output_data += msg.payload;
+    ack.ackno = msg.seqno + static_cast<uint32_t>( msg.sequence_length() );
+  };
+
+  const auto start_time = steady_clock::now();
+  while ( not ack.ackno.has_value() or not sender.reader().is_finished() ) {
+    while ( not split_data.empty() and split_data.front().size() <= sender.writer().available_capacity() ) {
+      sender.writer().push( move( split_data.front() ) );
+      split_data.pop();
+    }
+    if ( split_data.empty() and not sender.writer().is_closed() ) {
+      sender.writer().close();
+    }
+    sender.push( transmit );
+    sender.receive( ack );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and sent" );
+  }
+  if ( sender.sequence_numbers_in_flight() ) {
+    throw runtime_error( "TCPSender still has data in flight" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto bytes_per_second = static_cast<double>( input_len ) / test_duration.count();
+  auto gigabits_per_second = 8 * bytes_per_second / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCPSender with capacity=" << capacity << ", write_size=" << write_size
+       << ( mode == ByteStream::Mode::Chunked ? " (chunked)" : "" ) << " sent " << segments << " segments at "
+       << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+
+  debug_output << "             TCPSender throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
+               << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "TCPSender did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 1e8, 65536, 1067, 16384 );
+  speed_test( 1e8, 65536, 1067, 16384, ByteStream::Mode::Chunked );
+  speed_test( 1e7, 65536, 1067, 100, ByteStream::Mode::Chunked );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
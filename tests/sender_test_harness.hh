@@ -18,6 +18,7 @@ struct SenderAndOutput
 {
   TCPSender sender;
   std::queue<TCPSenderMessage> output {};
+  size_t max_payload_size = TCPConfig::MAX_PAYLOAD_SIZE;
 
   auto make_transmit()
   {
@@ -80,6 +81,34 @@ struct ExpectConsecutiveRetransmissions : public ExpectNumber<SenderAndOutput, u
   uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.consecutive_retransmissions(); }
 };
 
+struct ExpectCongestionWindow : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_window"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.congestion_window(); }
+};
+
+struct ExpectSmoothedRTT : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "smoothed_rtt"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.smoothed_rtt(); }
+};
+
+struct ExpectRTTVariation : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_variation"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.rtt_variation(); }
+};
+
+struct ExpectRTO : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "current_RTO_ms"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.current_RTO_ms(); }
+};
+
 struct ExpectNoSegment : public Expectation<SenderAndOutput>
 {
   std::string description() const override { return "nothing to send"; }
@@ -97,6 +126,15 @@ struct SetError : public Action<SenderAndOutput>
   void execute( SenderAndOutput& ss ) const override { ss.sender.writer().set_error(); }
 };
 
+struct SetPeerMSS : public Action<SenderAndOutput>
+{
+  uint64_t mss_;
+
+  explicit SetPeerMSS( uint64_t mss ) : mss_( mss ) {}
+  std::string description() const override { return "set_peer_mss(" + std::to_string( mss_ ) + ")"; }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_peer_mss( mss_ ); }
+};
+
 struct HasError : public ExpectBool<SenderAndOutput>
 {
   using ExpectBool::ExpectBool;
@@ -141,6 +179,12 @@ struct Push : public Action<SenderAndOutput>
   }
 };
 
+struct Flush : public Action<SenderAndOutput>
+{
+  std::string description() const override { return "flush TCPSender"; }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.flush( ss.make_transmit() ); }
+};
+
 struct Tick : public Action<SenderAndOutput>
 {
   uint64_t ms_;
@@ -192,19 +236,38 @@ struct Receive : public Action<SenderAndOutput>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    for ( const auto& block : msg_.sack ) {
+      desc << ", sack=[" << block.left << ", " << block.right << ")";
+    }
+    if ( msg_.timestamp_echo.has_value() ) {
+      desc << ", TSecr=" << msg_.timestamp_echo.value();
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push stream to TCPSender";
     }
     return desc.str();
   }
 
-  Receive& with_win( uint16_t win )
+  Receive& with_win( uint32_t win )
   {
     msg_.window_size = win;
     return *this;
   }
 
+  Receive& with_sack( Wrap32 left, Wrap32 right )
+  {
+    msg_.sack.push_back( { left, right } );
+    return *this;
+  }
+
+  Receive& with_timestamp_echo( uint32_t tsecr )
+  {
+    msg_.timestamp_echo = tsecr;
+    return *this;
+  }
+
   void execute( SenderAndOutput& ss ) const override
   {
     ss.sender.receive( msg_ );
@@ -238,6 +301,7 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<uint32_t> timestamp {};
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -283,6 +347,12 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     return *this;
   }
 
+  ExpectMessage& with_timestamp( uint32_t timestamp_ )
+  {
+    timestamp = timestamp_;
+    return *this;
+  }
+
   std::string message_description() const
   {
     std::ostringstream o;
@@ -308,6 +378,9 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( rst.has_value() ) {
       o << ( rst.value() ? " +RST" : " (no RST)" );
     }
+    if ( timestamp.has_value() ) {
+      o << " TSval=" << timestamp.value();
+    }
     return o.str();
   }
 
@@ -340,7 +413,7 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( payload_size.has_value() and seg.payload.size() != payload_size.value() ) {
       throw ExpectationViolation( "payload_size", payload_size.value(), seg.payload.size() );
     }
-    if ( seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE ) {
+    if ( seg.payload.size() > ss.max_payload_size ) {
       throw ExpectationViolation( "payload has length (" + std::to_string( seg.payload.size() )
                                   + ") greater than the maximum" );
     }
@@ -348,6 +421,9 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
       throw ExpectationViolation( "Expecting payload of \"" + Printer::prettify( data.value() )
                                   + "\", but instead it was \"" + Printer::prettify( seg.payload ) + "\"" );
     }
+    if ( timestamp.has_value() and seg.timestamp != timestamp ) {
+      throw ExpectationViolation( "timestamp", timestamp, seg.timestamp );
+    }
 
     ss.output.pop();
   }
@@ -359,6 +435,6 @@ public:
   TCPSenderTestHarness( std::string name, TCPConfig config )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ),
-                   { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout } } )
+                   { TCPSender { ByteStream { config.send_capacity }, config }, {}, config.mss } )
   {}
 };
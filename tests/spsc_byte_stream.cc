@@ -0,0 +1,127 @@
+#include "spsc_byte_stream.hh"
+
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Sleep until `event` is readable; a timeout means a wake-up was lost
+void wait_for( FileDescriptor& event, const string& what )
+{
+  pollfd pfd { event.fd_num(), POLLIN, 0 };
+  if ( ::poll( &pfd, 1, 5000 ) <= 0 ) {
+    throw runtime_error( "timed out waiting for " + what );
+  }
+}
+
+void single_thread_test()
+{
+  SPSCByteStream s { 6 };
+
+  if ( s.push( "hello, world" ) != 6 or s.available_capacity() != 0 or s.bytes_buffered() != 6 ) {
+    throw runtime_error( "push did not stop at capacity" );
+  }
+  if ( s.peek() != "hello," ) {
+    throw runtime_error( "unexpected peek: " + string( s.peek() ) );
+  }
+
+  s.pop( 4 );
+  if ( s.push( "abcd" ) != 4 or s.bytes_pushed() != 10 or s.bytes_popped() != 4 ) {
+    throw runtime_error( "unexpected counters after wrap-around" );
+  }
+
+  // capacity rounds up to 8, so the readable bytes are split at the end of the ring
+  string got;
+  while ( s.bytes_buffered() ) {
+    got += s.peek();
+    s.pop( s.peek().size() );
+  }
+  if ( got != "o,abcd" ) {
+    throw runtime_error( "unexpected data after wrap-around: " + got );
+  }
+
+  s.close();
+  if ( not s.is_finished() ) {
+    throw runtime_error( "stream not finished after close" );
+  }
+}
+
+void two_thread_test( const size_t input_len, const uint64_t capacity, const unsigned random_seed )
+{
+  const string data = [&] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  SPSCByteStream stream { capacity };
+
+  thread producer { [&] {
+    default_random_engine rd { random_seed + 1 };
+    uniform_int_distribution<size_t> chunk_size { 1, 2 * capacity };
+    size_t offset = 0;
+    while ( offset < data.size() ) {
+      stream.clear_space_event();
+      const size_t pushed = stream.push( string_view { data }.substr( offset, chunk_size( rd ) ) );
+      offset += pushed;
+      if ( pushed == 0 and stream.available_capacity() == 0 ) {
+        wait_for( stream.space_event(), "space" );
+      }
+    }
+    stream.close();
+  } };
+
+  string output;
+  try {
+    default_random_engine rd { random_seed + 2 };
+    uniform_int_distribution<size_t> read_size { 1, capacity };
+    while ( not stream.is_finished() ) {
+      stream.clear_data_event();
+      const auto view = stream.peek().substr( 0, read_size( rd ) );
+      output += view;
+      stream.pop( view.size() );
+      if ( view.empty() and not stream.is_closed() and stream.bytes_buffered() == 0 ) {
+        wait_for( stream.data_event(), "data" );
+      }
+    }
+  } catch ( ... ) {
+    stream.set_error();
+    producer.join();
+    throw;
+  }
+  producer.join();
+
+  if ( output != data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+  if ( stream.bytes_pushed() != input_len or stream.bytes_popped() != input_len ) {
+    throw runtime_error( "unexpected byte counts after transfer" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    single_thread_test();
+    two_thread_test( 100000, 17, 1234 );
+    two_thread_test( 1000000, 4096, 5678 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
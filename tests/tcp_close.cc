@@ -0,0 +1,83 @@
+#include "peer_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void expect_active( const TCPPeer& peer, bool active, const string& what )
+{
+  if ( peer.active() != active ) {
+    throw runtime_error( what + ( active ? " should still be active" : " should no longer be active" ) );
+  }
+}
+
+void passive_close_test()
+{
+  TCPConfig cfg;
+  Connection c { cfg };
+
+  // `a` closes first, so only `a` lingers once `b` has closed too
+  c.a.outbound_writer().close();
+  c.a.push( c.a_transmit() );
+  c.settle();
+  c.b.outbound_writer().close();
+  c.b.push( c.b_transmit() );
+  c.settle();
+  expect_active( c.a, true, "the active closer" );
+  expect_active( c.b, false, "the passive closer" );
+
+  c.tick( 10UL * cfg.rt_timeout );
+  expect_active( c.a, false, "the active closer after lingering" );
+}
+
+void simultaneous_close_test()
+{
+  TCPConfig cfg;
+  Connection c { cfg };
+
+  // the FINs cross, so each peer receives the other's FIN before the ACK of its own
+  c.a.outbound_writer().close();
+  c.a.push( c.a_transmit() );
+  c.b.outbound_writer().close();
+  c.b.push( c.b_transmit() );
+  if ( c.a_out.size() != 1 or not c.a_out[0].sender.FIN or c.b_out.size() != 1 or not c.b_out[0].sender.FIN ) {
+    throw runtime_error( "expected both peers to send a FIN" );
+  }
+  c.settle();
+  if ( c.a.sender().sequence_numbers_in_flight() or c.b.sender().sequence_numbers_in_flight() ) {
+    throw runtime_error( "both FINs should have been acknowledged" );
+  }
+
+  // both lingered in case their ACK of the other's FIN was lost
+  c.tick( cfg.rt_timeout );
+  expect_active( c.a, true, "a peer that closed simultaneously" );
+  expect_active( c.b, true, "a peer that closed simultaneously" );
+
+  c.tick( 10UL * cfg.rt_timeout );
+  expect_active( c.a, false, "a peer that closed simultaneously, after lingering," );
+  expect_active( c.b, false, "a peer that closed simultaneously, after lingering," );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    passive_close_test();
+    simultaneous_close_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
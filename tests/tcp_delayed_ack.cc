@@ -0,0 +1,177 @@
+#include "peer_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// A full segment's payload: the timestamps option takes 12 bytes of the MSS
+constexpr size_t FULL_PAYLOAD = TCPConfig::MAX_PAYLOAD_SIZE - 12;
+
+void expect_acks( const vector<TCPMessage>& replies, size_t count, const string& what )
+{
+  if ( replies.size() != count ) {
+    throw runtime_error( what + ": expected " + to_string( count ) + " ACKs, got " + to_string( replies.size() ) );
+  }
+  for ( const auto& msg : replies ) {
+    if ( not msg.receiver.ackno.has_value() or msg.sender.sequence_length() > 0 ) {
+      throw runtime_error( what + ": expected a pure ACK" );
+    }
+  }
+}
+
+void every_second_segment_test()
+{
+  TCPConfig cfg;
+  Connection c { cfg };
+
+  auto segments = c.send_data( 4 * FULL_PAYLOAD );
+  deliver( segments, c.b, c.b_out );
+  expect_acks( c.b_out, 2, "four full segments" );
+  c.b_out.clear();
+
+  // an odd segment waits for the timer
+  segments = c.send_data( 100 );
+  deliver( segments, c.b, c.b_out );
+  expect_acks( c.b_out, 0, "one segment" );
+  c.b.tick( cfg.ack_delay - 1, c.b_transmit() );
+  expect_acks( c.b_out, 0, "before the delayed-ACK timer" );
+  c.b.tick( 1, c.b_transmit() );
+  expect_acks( c.b_out, 1, "when the delayed-ACK timer expires" );
+  c.b_out.clear();
+  c.b.tick( 10 * cfg.ack_delay, c.b_transmit() );
+  expect_acks( c.b_out, 0, "after the delayed ACK went out" );
+}
+
+void out_of_order_test()
+{
+  TCPConfig cfg;
+  Connection c { cfg };
+
+  // the first segment is lost: the second, and the retransmission that fills the hole, are ACKed at once
+  auto segments = c.send_data( 2 * FULL_PAYLOAD );
+  vector<TCPMessage> first { segments.at( 0 ) };
+  vector<TCPMessage> second { segments.at( 1 ) };
+  deliver( second, c.b, c.b_out );
+  expect_acks( c.b_out, 1, "out-of-order segment" );
+  c.b_out.clear();
+  deliver( first, c.b, c.b_out );
+  expect_acks( c.b_out, 1, "segment that fills a hole" );
+  c.b_out.clear();
+
+  // so is a duplicate
+  vector<TCPMessage> duplicate { segments.at( 0 ) };
+  deliver( duplicate, c.b, c.b_out );
+  expect_acks( c.b_out, 1, "duplicate segment" );
+}
+
+void fin_test()
+{
+  TCPConfig cfg;
+  Connection c { cfg };
+
+  c.a.outbound_writer().close();
+  c.a.push( c.a_transmit() );
+  if ( c.a_out.size() != 1 or not c.a_out[0].sender.FIN ) {
+    throw runtime_error( "expected a FIN" );
+  }
+  deliver( c.a_out, c.b, c.b_out );
+  expect_acks( c.b_out, 1, "FIN" );
+}
+
+void piggyback_test()
+{
+  TCPConfig cfg;
+  Connection c { cfg };
+
+  auto segments = c.send_data( 100 );
+  deliver( segments, c.b, c.b_out );
+  expect_acks( c.b_out, 0, "one segment" );
+
+  // the reply carries the ACK, so the timer has nothing left to send
+  c.b.outbound_writer().push( "reply" );
+  c.b.push( c.b_transmit() );
+  if ( c.b_out.size() != 1 or c.b_out[0].sender.payload != "reply"
+       or c.b_out[0].receiver.ackno != c.b.receiver().send().ackno ) {
+    throw runtime_error( "expected the reply to acknowledge the data" );
+  }
+  c.b_out.clear();
+  c.b.tick( cfg.ack_delay, c.b_transmit() );
+  expect_acks( c.b_out, 0, "after the ACK was piggybacked" );
+}
+
+void timestamp_echo_test()
+{
+  TCPConfig cfg;
+  Connection c { cfg };
+
+  // the coalesced ACK echoes the earlier segment's timestamp, so the sender's RTT sample includes the delay
+  auto first = c.send_data( FULL_PAYLOAD );
+  c.a.tick( cfg.ack_delay / 2, c.a_transmit() );
+  auto second = c.send_data( FULL_PAYLOAD );
+  if ( first.size() != 1 or second.size() != 1 or not first[0].sender.timestamp.has_value()
+       or first[0].sender.timestamp == second[0].sender.timestamp ) {
+    throw runtime_error( "expected two segments with different timestamps" );
+  }
+  const auto tsval = first[0].sender.timestamp;
+  deliver( first, c.b, c.b_out );
+  deliver( second, c.b, c.b_out );
+  expect_acks( c.b_out, 1, "two segments" );
+  if ( c.b_out[0].receiver.timestamp_echo != tsval ) {
+    throw runtime_error( "the delayed ACK should echo the timestamp of the first segment it acknowledges" );
+  }
+}
+
+void disabled_test()
+{
+  TCPConfig cfg;
+  cfg.ack_delay = 0;
+  Connection c { cfg };
+
+  auto segments = c.send_data( 3 * FULL_PAYLOAD );
+  deliver( segments, c.b, c.b_out );
+  expect_acks( c.b_out, 3, "without delayed ACKs" );
+}
+
+void clamped_test()
+{
+  // a delay longer than MAX_ACK_DELAY would set off the sender's tail loss probes
+  TCPConfig cfg;
+  cfg.ack_delay = 10 * TCPConfig::MAX_ACK_DELAY;
+  Connection c { cfg };
+
+  auto segments = c.send_data( 100 );
+  deliver( segments, c.b, c.b_out );
+  c.b.tick( TCPConfig::MAX_ACK_DELAY - 1, c.b_transmit() );
+  expect_acks( c.b_out, 0, "before MAX_ACK_DELAY" );
+  c.b.tick( 1, c.b_transmit() );
+  expect_acks( c.b_out, 1, "once MAX_ACK_DELAY has passed" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    every_second_segment_test();
+    out_of_order_test();
+    fin_test();
+    piggyback_test();
+    timestamp_echo_test();
+    disabled_test();
+    clamped_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
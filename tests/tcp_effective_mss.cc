@@ -0,0 +1,94 @@
+#include "peer_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr uint64_t TCP_HEADER_LEN = 20;
+
+// Payload plus options of a segment, which must not exceed the MSS
+uint64_t segment_size( const TCPMessage& msg )
+{
+  return TCPSegment { .message = msg }.header_length() - TCP_HEADER_LEN + msg.sender.payload.size();
+}
+
+// Have `b` send data to `a` but lose its first segment, so that `a` has holes to report with SACK blocks
+void give_a_holes( Connection& c )
+{
+  c.b.outbound_writer().push( string( 3 * c.cfg.mss, 'y' ) );
+  c.b.push( c.b_transmit() );
+  if ( c.b_out.size() < 2 ) {
+    throw runtime_error( "expected at least two segments from b" );
+  }
+  c.b_out.erase( c.b_out.begin() );
+  deliver( c.b_out, c.a, c.a_out );
+  c.a_out.clear();
+}
+
+// Every segment `a` sends with `bytes` of data carries timestamps and SACK blocks; returns the largest one
+uint64_t largest_segment_with_options( Connection& c, size_t bytes )
+{
+  uint64_t largest = 0;
+  for ( const auto& msg : c.send_data( bytes ) ) {
+    if ( not msg.sender.timestamp.has_value() or msg.receiver.sack.empty() ) {
+      throw runtime_error( "expected every segment to carry timestamps and SACK blocks" );
+    }
+    if ( segment_size( msg ) > c.cfg.mss ) {
+      throw runtime_error( "a segment of " + to_string( segment_size( msg ) )
+                           + " bytes with its options does not fit the MSS of " + to_string( c.cfg.mss ) );
+    }
+    largest = max( largest, segment_size( msg ) );
+  }
+  return largest;
+}
+
+void options_fit_test()
+{
+  TCPConfig cfg;
+  cfg.mss = 1460;
+  Connection c { cfg };
+  give_a_holes( c );
+  if ( largest_segment_with_options( c, 4 * cfg.mss ) != cfg.mss ) {
+    throw runtime_error( "full segments should fill the MSS exactly, options included" );
+  }
+}
+
+void probe_fits_test()
+{
+  // PLPMTUD probes between MAX_PAYLOAD_SIZE and the MSS; the probe size counts the options too
+  TCPConfig cfg;
+  cfg.mss = 1460;
+  cfg.mtu_probing = true;
+  Connection c { cfg };
+  give_a_holes( c );
+  const uint64_t probe = ( TCPConfig::MAX_PAYLOAD_SIZE + cfg.mss + 1 ) / 2;
+  if ( largest_segment_with_options( c, 4 * cfg.mss ) != probe ) {
+    throw runtime_error( "the probe should be " + to_string( probe ) + " bytes with its options" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    options_fit_test();
+    probe_fits_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
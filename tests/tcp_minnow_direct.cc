@@ -0,0 +1,247 @@
+#include "exception.hh"
+#include "parser.hh"
+#include "tcp_minnow_socket_impl.hh"
+#include "tcp_over_ip.hh"
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <poll.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Carries IPv4 datagrams over one end of a Unix-domain SOCK_SEQPACKET socket pair instead of a TUN device
+class TCPOverIPv4OverSocketPairAdapter : public TCPOverIPv4Adapter
+{
+private:
+  FileDescriptor _fd;
+
+public:
+  explicit TCPOverIPv4OverSocketPairAdapter( FileDescriptor&& fd ) : _fd( std::move( fd ) )
+  {
+    _fd.set_blocking( false );
+  }
+
+  optional<TCPMessage> read()
+  {
+    vector<string> strs( 2 );
+    strs.front().resize( IPv4Header::LENGTH );
+    _fd.read( strs );
+    if ( strs.empty() ) {
+      return {};
+    }
+
+    InternetDatagram ip_dgram;
+    const vector<string> buffers = { strs.at( 0 ), strs.at( 1 ) };
+    if ( parse( ip_dgram, buffers ) ) {
+      return unwrap_tcp_in_ip( ip_dgram );
+    }
+    return {};
+  }
+
+  // A full socket buffer drops the datagram, like a full router queue; TCP retransmits it
+  void write( const TCPMessage& seg )
+  {
+    try {
+      _fd.write( serialize( wrap_tcp_in_ip( seg ) ) );
+    } catch ( const unix_error& e ) {
+      if ( e.error_code() != EAGAIN ) {
+        throw;
+      }
+    }
+  }
+
+  FileDescriptor& fd() { return _fd; }
+};
+
+static_assert( TCPDatagramAdapter<TCPOverIPv4OverSocketPairAdapter> );
+
+using DirectTestSocket = TCPMinnowSocket<TCPOverIPv4OverSocketPairAdapter>;
+
+// Sleep until `event` is readable; a timeout means a wake-up was lost
+void wait_for( FileDescriptor& event, const string& what )
+{
+  pollfd pfd { event.fd_num(), POLLIN, 0 };
+  if ( ::poll( &pfd, 1, 5000 ) <= 0 ) {
+    throw runtime_error( "timed out waiting for " + what );
+  }
+}
+
+void send_all( SPSCByteStream& out, string_view data )
+{
+  while ( not data.empty() ) {
+    out.clear_space_event();
+    data.remove_prefix( out.push( data ) );
+    if ( not data.empty() and out.available_capacity() == 0 ) {
+      wait_for( out.space_event(), "space in the outbound ring" );
+    }
+    if ( out.has_error() ) {
+      throw runtime_error( "outbound ring had error" );
+    }
+  }
+  out.close();
+}
+
+string receive_all( SPSCByteStream& in )
+{
+  string got;
+  while ( not in.is_finished() ) {
+    in.clear_data_event();
+    const auto view = in.peek();
+    got += view;
+    in.pop( view.size() );
+    if ( in.has_error() ) {
+      throw runtime_error( "inbound ring had error" );
+    }
+    if ( view.empty() and not in.is_closed() and in.bytes_buffered() == 0 ) {
+      wait_for( in.data_event(), "data in the inbound ring" );
+    }
+  }
+  return got;
+}
+
+// Connect `client` to `server` (which accepts in another thread) over the socket pair they were built on
+void connect_pair( DirectTestSocket& client, DirectTestSocket& server, const TCPConfig& cfg )
+{
+  FdAdapterConfig client_ad;
+  client_ad.source = Address { "10.144.0.1", 1234 };
+  client_ad.destination = Address { "10.144.0.2", 5678 };
+  FdAdapterConfig server_ad;
+  server_ad.source = Address { "10.144.0.2", 5678 };
+
+  thread accepter { [&] { server.listen_and_accept( cfg, server_ad ); } };
+  client.connect( cfg, client_ad );
+  accepter.join();
+}
+
+pair<FileDescriptor, FileDescriptor> datagram_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_SEQPACKET, 0, fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+// Both peers run a TCPMinnowSocket with direct streams; each side sends `len` bytes and reads the other's
+void direct_transfer_test( const size_t len, const uint64_t ring_capacity )
+{
+  const auto make_data = [len]( unsigned seed ) {
+    default_random_engine rd { seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  };
+  const string client_data = make_data( 1 );
+  const string server_data = make_data( 2 );
+
+  auto [client_fd, server_fd] = datagram_pair();
+  DirectTestSocket client { TCPOverIPv4OverSocketPairAdapter { std::move( client_fd ) } };
+  DirectTestSocket server { TCPOverIPv4OverSocketPairAdapter { std::move( server_fd ) } };
+  client.use_direct_streams( ring_capacity );
+  server.use_direct_streams( ring_capacity );
+
+  TCPConfig cfg;
+  cfg.rt_timeout = 10;
+  connect_pair( client, server, cfg );
+
+  string server_got;
+  thread server_side { [&] {
+    server_got = receive_all( server.direct_inbound() );
+    send_all( server.direct_outbound(), server_data );
+  } };
+  string client_got;
+  try {
+    send_all( client.direct_outbound(), client_data );
+    client_got = receive_all( client.direct_inbound() );
+  } catch ( ... ) {
+    server_side.join();
+    throw;
+  }
+  server_side.join();
+
+  client.wait_until_closed();
+  server.wait_until_closed();
+
+  if ( server_got != client_data ) {
+    throw runtime_error( "server received " + to_string( server_got.size() ) + " bytes, not the "
+                         + to_string( len ) + " the client sent" );
+  }
+  if ( client_got != server_data ) {
+    throw runtime_error( "client received " + to_string( client_got.size() ) + " bytes, not the "
+                         + to_string( len ) + " the server sent" );
+  }
+}
+
+// With a cork that would hold a small write for a minute, flush() sends it right away
+void flush_test()
+{
+  auto [client_fd, server_fd] = datagram_pair();
+  DirectTestSocket client { TCPOverIPv4OverSocketPairAdapter { std::move( client_fd ) } };
+  DirectTestSocket server { TCPOverIPv4OverSocketPairAdapter { std::move( server_fd ) } };
+  client.use_direct_streams( 4096 );
+  server.use_direct_streams( 4096 );
+
+  TCPConfig cfg;
+  cfg.rt_timeout = 10;
+  cfg.cork = true;
+  cfg.cork_timeout = 60000;
+  connect_pair( client, server, cfg );
+
+  if ( client.direct_outbound().push( "ping" ) != 4 ) {
+    throw runtime_error( "could not push to an empty outbound ring" );
+  }
+  client.flush();
+
+  SPSCByteStream& in = server.direct_inbound();
+  string got;
+  while ( got.size() < 4 ) {
+    in.clear_data_event();
+    const auto view = in.peek();
+    got += view;
+    in.pop( view.size() );
+    if ( view.empty() ) {
+      wait_for( in.data_event(), "flushed data" );
+    }
+  }
+  if ( got != "ping" ) {
+    throw runtime_error( "server received \"" + got + "\" instead of \"ping\"" );
+  }
+
+  client.direct_outbound().close();
+  server.direct_outbound().close();
+  receive_all( in );
+  receive_all( client.direct_inbound() );
+  client.wait_until_closed();
+  server.wait_until_closed();
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    direct_transfer_test( 1000, 4096 );
+    direct_transfer_test( 200000, 1024 );
+    flush_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+#include "peer_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Deliver all but the first of `segments` to `b`, so that it holds data beyond a hole; returns its replies
+vector<TCPMessage> deliver_with_hole( Connection& c, vector<TCPMessage> segments )
+{
+  if ( segments.size() < 2 ) {
+    throw runtime_error( "expected at least two segments" );
+  }
+  segments.erase( segments.begin() );
+  deliver( segments, c.b, c.b_out );
+  return move( c.b_out );
+}
+
+void negotiated_test()
+{
+  TCPConfig cfg;
+  Connection c { cfg };
+  const auto replies = deliver_with_hole( c, c.send_data( 3 * TCPConfig::MAX_PAYLOAD_SIZE ) );
+  if ( replies.empty() or replies.back().receiver.sack.empty() ) {
+    throw runtime_error( "with SACK negotiated, the ACK of out-of-order data should carry SACK blocks" );
+  }
+}
+
+void not_offered_test()
+{
+  TCPConfig cfg;
+  TCPPeer a { cfg };
+  TCPPeer b { cfg };
+  vector<TCPMessage> a_out;
+  vector<TCPMessage> b_out;
+
+  a.push( [&]( const TCPMessage& msg ) { a_out.push_back( msg ); } );
+  if ( a_out.size() != 1 or not a_out[0].receiver.sack_permitted ) {
+    throw runtime_error( "SYN should offer SACK" );
+  }
+  a_out[0].receiver.sack_permitted = false; // as if the peer did not support SACK
+  deliver( a_out, b, b_out );
+  if ( b_out.empty() or not b_out[0].sender.SYN or b_out[0].receiver.sack_permitted ) {
+    throw runtime_error( "SYN/ACK must not offer SACK when the SYN did not" );
+  }
+
+  deliver( b_out, a, a_out );
+  deliver( a_out, b, b_out );
+
+  // b holds data beyond a hole, but must not report it with SACK blocks
+  a.outbound_writer().push( string( 3 * TCPConfig::MAX_PAYLOAD_SIZE, 'x' ) );
+  a.push( [&]( const TCPMessage& msg ) { a_out.push_back( msg ); } );
+  a_out.erase( a_out.begin() );
+  deliver( a_out, b, b_out );
+  if ( b_out.empty() ) {
+    throw runtime_error( "out-of-order data should be acknowledged at once" );
+  }
+  for ( const auto& msg : b_out ) {
+    if ( not msg.receiver.sack.empty() ) {
+      throw runtime_error( "SACK blocks sent although SACK was not negotiated" );
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    negotiated_test();
+    not_offered_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
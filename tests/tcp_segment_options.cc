@@ -0,0 +1,309 @@
+#include "checksum.hh"
+#include "conversions.hh"
+#include "parser.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+string concat( const vector<string>& buffers )
+{
+  string ret;
+  for ( const auto& b : buffers ) {
+    ret += b;
+  }
+  return ret;
+}
+
+// A 20-byte header (seqno 1, ackno 2, ACK flag set, window 1000) followed by `options` and `payload`,
+// with the checksum filled in
+string raw_segment( const string& options, const string& payload )
+{
+  Serializer s;
+  s.integer( uint16_t { 1234 } );
+  s.integer( uint16_t { 80 } );
+  s.integer( uint32_t { 1 } );
+  s.integer( uint32_t { 2 } );
+  s.integer( static_cast<uint8_t>( ( 5 + options.size() / 4 ) << 4 ) );
+  s.integer( uint8_t { 0b0001'0000 } );
+  s.integer( uint16_t { 1000 } );
+  s.integer( uint16_t { 0 } ); // checksum
+  s.integer( uint16_t { 0 } ); // urgent pointer
+  string ret = concat( s.output() ) + options + payload;
+
+  InternetChecksum check;
+  check.add( ret );
+  ret[16] = static_cast<char>( check.value() >> 8 );
+  ret[17] = static_cast<char>( check.value() & 0xff );
+  return ret;
+}
+
+void expect_sack( const TCPSegment& seg, const vector<SACKBlock>& expected )
+{
+  if ( seg.message.receiver.sack != expected ) {
+    throw runtime_error( "expected " + to_string( expected.size() ) + " SACK blocks, got "
+                         + to_string( seg.message.receiver.sack.size() ) + " (or different contents)" );
+  }
+}
+
+void roundtrip_test()
+{
+  TCPSegment seg;
+  seg.message.sender.seqno = Wrap32 { 1000 };
+  seg.message.sender.payload = "hello";
+  seg.message.receiver.ackno = Wrap32 { 5000 };
+  seg.message.receiver.window_size = 4321;
+  seg.message.receiver.sack = { { Wrap32 { 6000 }, Wrap32 { 6100 } }, { Wrap32 { 5500 }, Wrap32 { 5600 } } };
+  seg.compute_checksum( 0 );
+
+  const auto bytes = serialize( seg );
+  if ( concat( bytes ).size() != 20 + 20 + 5 ) {
+    throw runtime_error( "unexpected serialized length: " + to_string( concat( bytes ).size() ) );
+  }
+  if ( seg.header_length() != 20 + 20 ) {
+    throw runtime_error( "header length does not count the SACK option" );
+  }
+
+  TCPSegment parsed;
+  if ( not parse( parsed, bytes, 0 ) ) {
+    throw runtime_error( "failed to parse a serialized segment with SACK blocks" );
+  }
+  expect_sack( parsed, seg.message.receiver.sack );
+  if ( parsed.message.sender.payload != "hello" or parsed.message.receiver.window_size != 4321
+       or parsed.message.receiver.ackno != Wrap32 { 5000 } ) {
+    throw runtime_error( "header fields did not survive the round trip" );
+  }
+
+  // no more than MAX_SACK_BLOCKS go on the wire, and none without an ackno
+  for ( uint32_t i = 0; i < 3; i++ ) {
+    seg.message.receiver.sack.push_back( { Wrap32 { 7000 + 10 * i }, Wrap32 { 7005 + 10 * i } } );
+  }
+  seg.compute_checksum( 0 );
+  if ( not parse( parsed, serialize( seg ), 0 ) ) {
+    throw runtime_error( "failed to parse a segment with too many SACK blocks" );
+  }
+  expect_sack( parsed, { seg.message.receiver.sack.begin(), seg.message.receiver.sack.begin() + 4 } );
+
+  seg.message.receiver.ackno.reset();
+  seg.compute_checksum( 0 );
+  if ( concat( serialize( seg ) ).size() != 20 + 5 ) {
+    throw runtime_error( "SACK option sent without an ackno" );
+  }
+}
+
+void parse_test()
+{
+  // MSS, NOP, SACK with one block, then end-of-options padding
+  const string options = string { "\x02\x04\x05\xb4", 4 } + "\x01" + string { "\x05\x0a\x00\x00\x00\x10", 6 }
+                         + string { "\x00\x00\x00\x20\x00\x00\x00\x00\x00", 9 };
+  TCPSegment seg;
+  if ( not parse( seg, { raw_segment( options, "data" ) }, 0 ) ) {
+    throw runtime_error( "failed to parse segment with MSS and SACK options" );
+  }
+  expect_sack( seg, { { Wrap32 { 0x10 }, Wrap32 { 0x20 } } } );
+  if ( seg.message.receiver.mss != 1460 ) {
+    throw runtime_error( "MSS option misparsed" );
+  }
+  if ( seg.message.sender.payload != "data" ) {
+    throw runtime_error( "payload misparsed after options" );
+  }
+
+  // an option whose length runs past the header
+  TCPSegment bad;
+  if ( parse( bad, { raw_segment( string { "\x01\x01\x02\x08", 4 }, "data" ) }, 0 ) ) {
+    throw runtime_error( "accepted an option that runs past the header" );
+  }
+
+  // a SACK option whose length is not a whole number of blocks
+  if ( parse( bad, { raw_segment( string { "\x05\x06\x00\x00\x00\x01\x00\x00", 8 }, "" ) }, 0 ) ) {
+    throw runtime_error( "accepted a malformed SACK option" );
+  }
+}
+
+void window_scale_test()
+{
+  TCPSegment syn;
+  syn.message.sender.SYN = true;
+  syn.message.receiver.window_size = 100'000; // too big for the field: clamped, not truncated
+  syn.message.receiver.window_scale = 7;
+  syn.compute_checksum( 0 );
+  if ( concat( serialize( syn ) ).size() != 20 + 4 ) {
+    throw runtime_error( "window scale option not serialized on a SYN" );
+  }
+  TCPSegment parsed;
+  if ( not parse( parsed, serialize( syn ), 0 ) ) {
+    throw runtime_error( "failed to parse a SYN with a window scale option" );
+  }
+  if ( parsed.message.receiver.window_scale != 7 or parsed.message.receiver.window_size != UINT16_MAX ) {
+    throw runtime_error( "window scale or window did not survive the round trip" );
+  }
+
+  // the option is only allowed on a SYN
+  syn.message.sender.SYN = false;
+  syn.compute_checksum( 0 );
+  if ( concat( serialize( syn ) ).size() != 20 ) {
+    throw runtime_error( "window scale option sent without SYN" );
+  }
+
+  // shift counts above 14 are treated as 14
+  if ( not parse( parsed, { raw_segment( string { "\x01\x03\x03\x1e", 4 }, "" ) }, 0 ) ) {
+    throw runtime_error( "failed to parse a window scale option" );
+  }
+  if ( parsed.message.receiver.window_scale != TCPReceiverMessage::MAX_WINDOW_SCALE ) {
+    throw runtime_error( "window scale above 14 was not clamped" );
+  }
+
+  if ( parse( parsed, { raw_segment( string { "\x03\x04\x07\x00", 4 }, "" ) }, 0 ) ) {
+    throw runtime_error( "accepted a window scale option with the wrong length" );
+  }
+}
+
+void timestamps_test()
+{
+  TCPSegment seg;
+  seg.message.sender.seqno = Wrap32 { 1000 };
+  seg.message.sender.timestamp = 0x01020304;
+  seg.message.receiver.ackno = Wrap32 { 5000 };
+  seg.message.receiver.timestamp_echo = 0xa0b0c0d0;
+  seg.compute_checksum( 0 );
+  if ( concat( serialize( seg ) ).size() != 20 + 12 ) {
+    throw runtime_error( "timestamps option not serialized" );
+  }
+  TCPSegment parsed;
+  if ( not parse( parsed, serialize( seg ), 0 ) ) {
+    throw runtime_error( "failed to parse a segment with timestamps" );
+  }
+  if ( parsed.message.sender.timestamp != 0x01020304 or parsed.message.receiver.timestamp_echo != 0xa0b0c0d0 ) {
+    throw runtime_error( "timestamps did not survive the round trip" );
+  }
+
+  // alongside timestamps only three SACK blocks fit in the 40 bytes of option space
+  for ( uint32_t i = 0; i < 4; i++ ) {
+    seg.message.receiver.sack.push_back( { Wrap32 { 7000 + 10 * i }, Wrap32 { 7005 + 10 * i } } );
+  }
+  seg.compute_checksum( 0 );
+  if ( concat( serialize( seg ) ).size() != 20 + 40 ) {
+    throw runtime_error( "options should fill exactly 40 bytes" );
+  }
+  if ( not parse( parsed, serialize( seg ), 0 ) ) {
+    throw runtime_error( "failed to parse a segment with timestamps and SACK blocks" );
+  }
+  expect_sack( parsed, { seg.message.receiver.sack.begin(), seg.message.receiver.sack.begin() + 3 } );
+
+  // TSecr means nothing without the ACK flag; a later segment without the option has no timestamps
+  seg.message.receiver.ackno.reset();
+  seg.compute_checksum( 0 );
+  if ( not parse( parsed, serialize( seg ), 0 ) ) {
+    throw runtime_error( "failed to parse a segment with timestamps and no ACK" );
+  }
+  if ( parsed.message.sender.timestamp != 0x01020304 or parsed.message.receiver.timestamp_echo.has_value() ) {
+    throw runtime_error( "TSecr should be ignored without the ACK flag" );
+  }
+  if ( not parse( parsed, { raw_segment( "", "" ) }, 0 ) or parsed.message.sender.timestamp.has_value() ) {
+    throw runtime_error( "timestamps left over from a previous parse" );
+  }
+
+  if ( parse( parsed, { raw_segment( string { "\x08\x06\x00\x00\x00\x01\x01\x01", 8 }, "" ) }, 0 ) ) {
+    throw runtime_error( "accepted a timestamps option with the wrong length" );
+  }
+}
+
+void mss_test()
+{
+  TCPSegment syn;
+  syn.message.sender.SYN = true;
+  syn.message.sender.timestamp = 1;
+  syn.message.receiver.mss = 8960;
+  syn.message.receiver.window_scale = 7;
+  syn.compute_checksum( 0 );
+  if ( concat( serialize( syn ) ).size() != 20 + 4 + 4 + 12 ) {
+    throw runtime_error( "MSS option not serialized on a SYN" );
+  }
+  TCPSegment parsed;
+  if ( not parse( parsed, serialize( syn ), 0 ) ) {
+    throw runtime_error( "failed to parse a SYN with MSS, window scale and timestamps" );
+  }
+  if ( parsed.message.receiver.mss != 8960 or parsed.message.receiver.window_scale != 7
+       or parsed.message.sender.timestamp != 1 ) {
+    throw runtime_error( "SYN options did not survive the round trip" );
+  }
+  if ( parsed.header_length() != 20 + 4 + 4 + 12 ) {
+    throw runtime_error( "header length does not count the options" );
+  }
+
+  // the option is only allowed on a SYN
+  syn.message.sender.SYN = false;
+  syn.message.sender.timestamp.reset();
+  syn.compute_checksum( 0 );
+  if ( concat( serialize( syn ) ).size() != 20 ) {
+    throw runtime_error( "MSS option sent without SYN" );
+  }
+  if ( not parse( parsed, serialize( syn ), 0 ) or parsed.message.receiver.mss.has_value() ) {
+    throw runtime_error( "MSS left over from a previous parse" );
+  }
+
+  if ( parse( parsed, { raw_segment( string { "\x02\x03\x05\x00", 4 }, "" ) }, 0 ) ) {
+    throw runtime_error( "accepted an MSS option with the wrong length" );
+  }
+}
+
+void sack_permitted_test()
+{
+  TCPSegment syn;
+  syn.message.sender.SYN = true;
+  syn.message.sender.timestamp = 1;
+  syn.message.receiver.mss = 1460;
+  syn.message.receiver.window_scale = 7;
+  syn.message.receiver.sack_permitted = true;
+  syn.compute_checksum( 0 );
+  if ( concat( serialize( syn ) ).size() != 20 + 4 + 4 + 4 + 12 ) {
+    throw runtime_error( "SACK-permitted option not serialized on a SYN" );
+  }
+  TCPSegment parsed;
+  if ( not parse( parsed, serialize( syn ), 0 ) or not parsed.message.receiver.sack_permitted
+       or parsed.message.receiver.mss != 1460 or parsed.message.receiver.window_scale != 7 ) {
+    throw runtime_error( "SYN options with SACK-permitted did not survive the round trip" );
+  }
+
+  // like the window scale, the option is only allowed on a SYN
+  syn.message.sender.SYN = false;
+  syn.message.sender.timestamp.reset();
+  syn.compute_checksum( 0 );
+  if ( concat( serialize( syn ) ).size() != 20 ) {
+    throw runtime_error( "SACK-permitted option sent without SYN" );
+  }
+  if ( not parse( parsed, serialize( syn ), 0 ) or parsed.message.receiver.sack_permitted ) {
+    throw runtime_error( "SACK-permitted left over from a previous parse" );
+  }
+
+  if ( parse( parsed, { raw_segment( string { "\x04\x03\x00\x01", 4 }, "" ) }, 0 ) ) {
+    throw runtime_error( "accepted a SACK-permitted option with the wrong length" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    roundtrip_test();
+    parse_test();
+    window_scale_test();
+    timestamps_test();
+    mss_test();
+    sack_permitted_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+#include "peer_test_harness.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Handshake, then send data from `a` to `b` for two round trips; returns a's sequence numbers in flight
+uint64_t transfer( TCPPeer& a, TCPPeer& b, bool strip_offer )
+{
+  vector<TCPMessage> a_out;
+  vector<TCPMessage> b_out;
+  auto a_transmit = [&]( const TCPMessage& msg ) { a_out.push_back( msg ); };
+
+  a.push( a_transmit );
+  if ( a_out.size() != 1 or not a_out[0].sender.SYN ) {
+    throw runtime_error( "expected a SYN" );
+  }
+  if ( a_out[0].receiver.window_scale != 4 or a_out[0].receiver.window_size != UINT16_MAX ) {
+    throw runtime_error( "SYN should offer shift 4 (for a 1 MB window) with an unscaled window" );
+  }
+  if ( strip_offer ) {
+    a_out[0].receiver.window_scale.reset(); // as if the option were lost or unsupported
+  }
+
+  const auto syn_timestamp = a_out[0].sender.timestamp;
+  deliver( a_out, b, b_out );
+  if ( b_out.empty() or not b_out[0].sender.SYN ) {
+    throw runtime_error( "expected a SYN/ACK" );
+  }
+  if ( b_out[0].receiver.window_scale.has_value() == strip_offer ) {
+    throw runtime_error( "SYN/ACK must offer window scaling exactly when the SYN did" );
+  }
+  if ( b_out[0].receiver.window_size != UINT16_MAX ) {
+    throw runtime_error( "the window in a SYN/ACK is never scaled" );
+  }
+  if ( not syn_timestamp.has_value() or b_out[0].receiver.timestamp_echo != syn_timestamp ) {
+    throw runtime_error( "SYN/ACK should offer timestamps and echo the SYN's" );
+  }
+
+  deliver( b_out, a, a_out );
+  const uint32_t expected_ack_window = strip_offer ? UINT16_MAX : 1'000'000 >> 4;
+  if ( a_out.empty() or a_out.back().receiver.window_size != expected_ack_window ) {
+    throw runtime_error( "unexpected window on the ACK of the SYN/ACK" );
+  }
+
+  a.outbound_writer().push( string( 500'000, 'x' ) );
+  a.push( a_transmit );
+  deliver( a_out, b, b_out );
+  deliver( b_out, a, a_out );
+  a.push( a_transmit );
+  return a.sender().sequence_numbers_in_flight();
+}
+
+void negotiated_test()
+{
+  TCPConfig cfg;
+  cfg.recv_capacity = 1'000'000;
+  cfg.send_capacity = 1'000'000;
+  TCPPeer a { cfg };
+  TCPPeer b { cfg };
+  const uint64_t in_flight = transfer( a, b, false );
+  if ( in_flight <= UINT16_MAX ) {
+    throw runtime_error( "with window scaling more than 64 KB should be in flight, got "
+                         + to_string( in_flight ) );
+  }
+}
+
+void not_offered_test()
+{
+  TCPConfig cfg;
+  cfg.recv_capacity = 1'000'000;
+  cfg.send_capacity = 1'000'000;
+  TCPPeer a { cfg };
+  TCPPeer b { cfg };
+  const uint64_t in_flight = transfer( a, b, true );
+  if ( in_flight > UINT16_MAX ) {
+    throw runtime_error( "without window scaling at most 64 KB may be in flight, got " + to_string( in_flight ) );
+  }
+}
+
+void autotuning_test()
+{
+  // the shift must cover the largest window auto-tuning may grow to, since it is fixed by the SYN
+  TCPConfig cfg;
+  cfg.recv_capacity = 16'000;
+  cfg.max_recv_capacity = 1'000'000;
+  TCPPeer a { cfg };
+  vector<TCPMessage> a_out;
+  a.push( [&]( const TCPMessage& msg ) { a_out.push_back( msg ); } );
+  if ( a_out.size() != 1 or a_out[0].receiver.window_scale != 4 or a_out[0].receiver.window_size != 16'000 ) {
+    throw runtime_error( "SYN should offer the shift for the auto-tuning ceiling with the initial window" );
+  }
+}
+
+void send_buffer_growth_test()
+{
+  // bytes in flight stay in the send buffer, but must not keep the application from queueing send_capacity more
+  TCPConfig cfg;
+  cfg.recv_capacity = 1'000'000;
+  cfg.max_send_capacity = 1'000'000;
+  TCPPeer a { cfg };
+  TCPPeer b { cfg };
+  transfer( a, b, false );
+
+  vector<TCPMessage> a_out;
+  for ( int i = 0; i < 3; ++i ) {
+    if ( a.outbound_writer().available_capacity() < cfg.send_capacity ) {
+      throw runtime_error( "bytes in flight should not take room from the application" );
+    }
+    a.outbound_writer().push( string( cfg.send_capacity, 'x' ) );
+    a.push( [&]( const TCPMessage& msg ) { a_out.push_back( msg ); } );
+  }
+  if ( a.sender().sequence_numbers_in_flight() < 3 * cfg.send_capacity ) {
+    throw runtime_error( "the scaled window should be filled past send_capacity, but "
+                         + to_string( a.sender().sequence_numbers_in_flight() ) + " bytes are in flight" );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    negotiated_test();
+    not_offered_test();
+    autotuning_test();
+    send_buffer_growth_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <span>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -65,12 +66,22 @@ public:
   void read( std::string& buffer );
   void read( std::vector<std::string>& buffers );
 
+  // Read into caller-owned memory
+  // returns number of bytes read (0 at EOF or if a non-blocking read would block)
+  size_t read( std::span<char> buffer );
+  size_t read( const std::vector<std::span<char>>& buffers );
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
   size_t write( const std::vector<std::string_view>& buffers );
   size_t write( const std::vector<std::string>& buffers );
 
+  // Move up to `len` bytes from this descriptor to `out` without copying them through user space
+  // (see [splice(2)](\ref man2::splice); one of the two descriptors must be a pipe)
+  // returns number of bytes moved (0 at EOF or if the splice would block)
+  size_t splice_to( FileDescriptor& out, size_t len );
+
   // Close the underlying file descriptor
   void close() { internal_fd_->close(); }
 
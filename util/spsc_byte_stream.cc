@@ -0,0 +1,124 @@
+#include "spsc_byte_stream.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/eventfd.h>
+
+using namespace std;
+
+// The producer publishes tail_ and then reads head_; the consumer publishes head_ and then reads tail_.
+// Both pairs are sequentially consistent, so at least one side always sees the other's latest update:
+// either the consumer sees the new bytes before deciding to sleep, or the producer sees that the consumer
+// had drained the stream and signals data_event_. The same argument applies to space_event_.
+
+// The ring cannot grow once both threads are using it, so it is allocated in full here (bit_ceil is undefined
+// above 2^63, so larger capacities are rejected rather than rounded)
+SPSCByteStream::SPSCByteStream( uint64_t capacity )
+  : capacity_( capacity <= ( uint64_t { 1 } << 63 ) ? capacity
+                                                    : throw invalid_argument( "SPSCByteStream capacity too large" ) )
+  , mask_( bit_ceil( max( capacity, uint64_t { 1 } ) ) - 1 )
+  , buffer_( make_unique<char[]>( mask_ + 1 ) ) // NOLINT(*-avoid-c-arrays)
+  , data_event_( CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) )
+  , space_event_( CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) )
+{}
+
+uint64_t SPSCByteStream::push( string_view data )
+{
+  const uint64_t tail = tail_.load( memory_order_relaxed );
+  const uint64_t head = head_.load();
+  const uint64_t len = min( static_cast<uint64_t>( data.size() ), capacity_ - ( tail - head ) );
+  if ( len == 0 ) {
+    return 0;
+  }
+
+  const uint64_t start = tail & mask_;
+  const uint64_t first = min( len, mask_ + 1 - start );
+  memcpy( buffer_.get() + start, data.data(), first );
+  memcpy( buffer_.get(), data.data() + first, len - first );
+
+  tail_.store( tail + len );
+  if ( head_.load() == tail ) {
+    signal_event( data_event_ ); // the consumer may have found the stream empty and gone to sleep
+  }
+  return len;
+}
+
+void SPSCByteStream::close()
+{
+  closed_.store( true );
+  signal_event( data_event_ );
+}
+
+void SPSCByteStream::set_error()
+{
+  error_.store( true );
+  signal_event( data_event_ );
+  signal_event( space_event_ );
+}
+
+uint64_t SPSCByteStream::available_capacity() const
+{
+  return capacity_ - ( tail_.load( memory_order_relaxed ) - head_.load() );
+}
+
+uint64_t SPSCByteStream::bytes_pushed() const
+{
+  return tail_.load();
+}
+
+string_view SPSCByteStream::peek() const
+{
+  const uint64_t head = head_.load( memory_order_relaxed );
+  const uint64_t start = head & mask_;
+  const uint64_t len = min( tail_.load( memory_order_acquire ) - head, mask_ + 1 - start );
+  return { buffer_.get() + start, len };
+}
+
+void SPSCByteStream::pop( uint64_t len )
+{
+  const uint64_t head = head_.load( memory_order_relaxed );
+  len = min( len, tail_.load() - head );
+  if ( len == 0 ) {
+    return;
+  }
+
+  head_.store( head + len );
+  if ( tail_.load() - head == capacity_ ) {
+    signal_event( space_event_ ); // the producer may have found the stream full and gone to sleep
+  }
+}
+
+bool SPSCByteStream::is_finished() const
+{
+  return is_closed() and bytes_buffered() == 0;
+}
+
+uint64_t SPSCByteStream::bytes_buffered() const
+{
+  return tail_.load() - head_.load( memory_order_relaxed );
+}
+
+uint64_t SPSCByteStream::bytes_popped() const
+{
+  return head_.load();
+}
+
+void SPSCByteStream::signal_event( FileDescriptor& event )
+{
+  const uint64_t one = 1;
+  array<char, sizeof( one )> buf {};
+  memcpy( buf.data(), &one, sizeof( one ) );
+  event.write( string_view { buf.data(), buf.size() } );
+}
+
+void SPSCByteStream::clear_event( FileDescriptor& event )
+{
+  string buf( sizeof( uint64_t ), 0 );
+  event.read( buf ); // non-blocking: leaves buf empty if the counter was already zero
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+//! \brief A ByteStream that can be shared by exactly one producer thread and one consumer thread
+//! \details The producer calls the Writer-side methods (push, close, available_capacity, bytes_pushed) and
+//! the consumer calls the Reader-side methods (peek, pop, is_finished, bytes_buffered, bytes_popped). Neither
+//! side takes a lock: the read and write indices are atomics that each live on their own cache line.
+//!
+//! Each side can also sleep in an EventLoop (or poll) on an eventfd:
+//! - data_event() becomes readable when bytes (or the end of the stream) arrive after the consumer had
+//!   drained everything it could see, and
+//! - space_event() becomes readable when space is freed after the producer had filled the buffer.
+//!
+//! A side that wakes up on its eventfd must call clear_data_event() or clear_space_event() *before*
+//! looking at the stream again. The eventfds are only written on those empty/full transitions, so a
+//! steady stream of chunks does not cost a system call per chunk.
+class SPSCByteStream
+{
+public:
+  explicit SPSCByteStream( uint64_t capacity );
+
+  //! \name Producer side
+  //!@{
+  uint64_t push( std::string_view data ); //!< Push as much of data as fits; returns the number of bytes pushed
+  void close();                           //!< Signal that nothing more will be written
+  uint64_t available_capacity() const;    //!< How many bytes can be pushed right now?
+  uint64_t bytes_pushed() const;          //!< Total number of bytes cumulatively pushed
+  //!@}
+
+  //! \name Consumer side
+  //!@{
+  std::string_view peek() const;   //!< Largest contiguous readable region
+  void pop( uint64_t len );        //!< Remove `len` bytes from the front of the stream
+  bool is_finished() const;        //!< Is the stream closed and fully popped?
+  uint64_t bytes_buffered() const; //!< Number of bytes pushed and not yet popped
+  uint64_t bytes_popped() const;   //!< Total number of bytes cumulatively popped
+  //!@}
+
+  //! \name Either side
+  //!@{
+  bool is_closed() const { return closed_.load( std::memory_order_acquire ); }
+  void set_error();
+  bool has_error() const { return error_.load( std::memory_order_acquire ); }
+  //!@}
+
+  //! \name Wake-up notifications
+  //!@{
+  FileDescriptor& data_event() { return data_event_; }   //!< readable when the consumer has work to do
+  FileDescriptor& space_event() { return space_event_; } //!< readable when the producer has room again
+  void clear_data_event() { clear_event( data_event_ ); }
+  void clear_space_event() { clear_event( space_event_ ); }
+  //!@}
+
+  //! The stream is shared by two threads by reference, so it can be neither copied nor moved
+  SPSCByteStream( const SPSCByteStream& other ) = delete;
+  SPSCByteStream& operator=( const SPSCByteStream& other ) = delete;
+  SPSCByteStream( SPSCByteStream&& other ) = delete;
+  SPSCByteStream& operator=( SPSCByteStream&& other ) = delete;
+  ~SPSCByteStream() = default;
+
+private:
+  static constexpr size_t kCacheLine = 64;
+
+  static void signal_event( FileDescriptor& event );
+  static void clear_event( FileDescriptor& event );
+
+  // Immutable after construction
+  uint64_t capacity_;
+  uint64_t mask_;
+  std::unique_ptr<char[]> buffer_;
+
+  // Written only by the producer: total bytes pushed (the unmasked write index)
+  alignas( kCacheLine ) std::atomic<uint64_t> tail_ { 0 };
+
+  // Written only by the consumer: total bytes popped (the unmasked read index)
+  alignas( kCacheLine ) std::atomic<uint64_t> head_ { 0 };
+
+  alignas( kCacheLine ) std::atomic<bool> closed_ { false };
+  std::atomic<bool> error_ { false };
+
+  FileDescriptor data_event_;
+  FileDescriptor space_event_;
+};
@@ -11,15 +11,91 @@
 class TCPConfig
 {
 public:
-  static constexpr size_t DEFAULT_CAPACITY = 64000; //!< Default capacity
-  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
-  static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
-  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
+  static constexpr size_t DEFAULT_CAPACITY = 64000;   //!< Default capacity
+  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;    //!< Conservative max payload size for real Internet
+  static constexpr uint16_t TIMEOUT_DFLT = 1000;      //!< Default re-transmit timeout is 1 second
+  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;    //!< Maximum re-transmit attempts before giving up
+  static constexpr unsigned DUP_THRESH = 3;           //!< SACKed segments above a hole before it is deemed lost
+  static constexpr uint16_t MIN_RTO_DFLT = 200;       //!< Lower bound on the adaptive RTO (as in Linux)
+  static constexpr uint16_t MAX_RTO_DFLT = 60000;     //!< Upper bound on the adaptive RTO (RFC 6298 2.5)
+  static constexpr uint16_t MIN_PTO = 10;             //!< Lower bound on the tail loss probe timeout (as in Linux)
+  static constexpr uint16_t MAX_ACK_DELAY = 200;      //!< Longest a receiver may delay an ACK (RFC 8985 WCDelAckT)
+  static constexpr uint16_t ACK_DELAY_DFLT = 40;      //!< Default delayed-ACK timeout (as in Linux)
+  static constexpr size_t DEFAULT_MSS = 536;          //!< MSS assumed when the peer's SYN has none (RFC 9293 3.7.1)
+  static constexpr unsigned MAX_PROBES = 3;           //!< Lost PLPMTUD probes before a size is ruled out (RFC 8899)
+  static constexpr size_t MIN_PROBE_STEP = 16;        //!< PLPMTUD stops once its search range is narrower than this
+  static constexpr uint16_t CORK_TIMEOUT_DFLT = 200;  //!< Longest corked data waits for more (as in Linux)
+  static constexpr unsigned INITIAL_WINDOW_DFLT = 10; //!< Initial congestion window, in segments (RFC 6928)
+
+  //! Congestion control algorithm used by the TCPSender
+  enum class CongestionControl : uint8_t
+  {
+    None,  //!< Send whatever the receiver's window allows
+    Reno,  //!< RFC 5681 slow start and congestion avoidance
+    Cubic, //!< RFC 9438 CUBIC
+    BBR,   //!< A simplified model-based controller in the style of BBR
+  };
 
   uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
+
+  //! Receive-window auto-tuning: let the receive capacity grow from recv_capacity up to this many bytes, to
+  //! twice what the application reads per RTT (0 keeps it fixed at recv_capacity)
+  size_t max_recv_capacity = 0;
+
+  //! Sent bytes stay in the send buffer until they are acknowledged: let it grow past send_capacity by the bytes
+  //! in flight, up to this many bytes, so that the application can still queue send_capacity bytes (0 keeps it
+  //! fixed at send_capacity, shared by the bytes in flight and the bytes queued)
+  size_t max_send_capacity = 0;
   Wrap32 isn { 137 };                      //!< Default initial sequence number
+
+  //! Delay the ACK of in-order data by up to this many milliseconds, acknowledging every second segment at
+  //! once (RFC 1122 4.2.3.2); larger values are clamped to MAX_ACK_DELAY, and 0 acknowledges every segment
+  //! immediately
+  uint16_t ack_delay = ACK_DELAY_DFLT;
+
+  //! Largest payload the local MTU allows: advertised in the SYN's MSS option and never exceeded when sending
+  size_t mss = MAX_PAYLOAD_SIZE;
+
+  //! Packetization layer path MTU discovery (RFC 8899): start from MAX_PAYLOAD_SIZE and send larger probe
+  //! segments (with DF set) to find the largest payload the path carries, up to mss and the peer's MSS
+  bool mtu_probing = false;
+
+  //! Congestion control algorithm (the default keeps the sender limited only by the receiver's window)
+  CongestionControl congestion_control = CongestionControl::None;
+
+  //! Segments the congestion controller may send before the first ACK of data, capped at initial_window * 1460
+  //! bytes when the MSS is larger (RFC 6928; 4 gives the RFC 5681 window for an MSS of at most 1095)
+  unsigned initial_window = INITIAL_WINDOW_DFLT;
+
+  //! Compute the RTO from measured RTTs (RFC 6298) instead of always starting from rt_timeout
+  bool adaptive_rto = false;
+  uint16_t min_rto = MIN_RTO_DFLT; //!< Smallest adaptive RTO, in milliseconds
+  uint16_t max_rto = MAX_RTO_DFLT; //!< Largest adaptive RTO (including backoff), in milliseconds
+
+  //! Without SACK from the receiver, retransmit after DUP_THRESH duplicate ACKs and recover as NewReno does
+  bool fast_retransmit = false;
+
+  //! Probe a zero window from a persist timer with exponential backoff (RFC 9293 3.8.6.1) instead of sending
+  //! one byte as if the window were 1 and resending it on every RTO
+  bool persist_timer = false;
+
+  //! Nagle's algorithm (RFC 896, RFC 1122 4.2.3.4): while any data is unacknowledged, hold back a segment that
+  //! would carry less than a full MSS, so that small writes are coalesced
+  bool nagle = false;
+
+  //! Cork: hold back less than a full MSS of data until flush() is called or it has waited cork_timeout ms
+  bool cork = false;
+  uint16_t cork_timeout = CORK_TIMEOUT_DFLT;
+
+  //! Detect loss from the send times of SACKed segments and probe for tail loss before the RTO (RFC 8985)
+  bool rack_tlp = false;
+
+  //! Release segments from a token bucket refilled by tick() instead of sending the whole window at once
+  bool pacing = false;
+  uint64_t pacing_rate = 0;                    //!< Bytes per second (0 = the congestion controller's rate)
+  uint64_t pacing_burst = 2 * MAX_PAYLOAD_SIZE; //!< Token bucket depth: the largest burst, in bytes
 };
 
 //! Config for classes derived from FdAdapter
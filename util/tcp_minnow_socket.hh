@@ -4,12 +4,14 @@
 #include "eventloop.hh"
 #include "file_descriptor.hh"
 #include "socket.hh"
+#include "spsc_byte_stream.hh"
 #include "tcp_config.hh"
 #include "tcp_peer.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <thread>
 #include <vector>
@@ -33,6 +35,25 @@ public:
   //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
   void listen_and_accept( const TCPConfig& c_tcp, const FdAdapterConfig& c_ad );
 
+  //! Send the bytes written so far even if TCPConfig::nagle or TCPConfig::cork is holding them back
+  void flush();
+
+  //! \brief Exchange bytes with the TCPPeer thread through two shared-memory rings of `capacity` bytes each,
+  //! instead of through this socket's file descriptor
+  //! \note Must be called before connect() or listen_and_accept(). After that, the owner must not read from
+  //! or write to the socket itself.
+  void use_direct_streams( uint64_t capacity );
+
+  //! \name
+  //! The owner's ends of the rings set up by use_direct_streams(). The owner push()es and close()s the
+  //! outbound ring and waits on its space_event() when it is full; it peek()s and pop()s the inbound ring
+  //! and waits on its data_event() when it is empty. An error on the connection sets both rings' error flag.
+
+  //!@{
+  SPSCByteStream& direct_outbound();
+  SPSCByteStream& direct_inbound();
+  //!@}
+
   //! When a connected socket is destructed, it will send a RST
   ~TCPMinnowSocket();
 
@@ -78,6 +99,16 @@ private:
   //! Process events while specified condition is true
   void _tcp_loop( const std::function<bool()>& condition );
 
+  //! Rings shared with the owner when it has called use_direct_streams() (both null otherwise)
+  std::unique_ptr<SPSCByteStream> _direct_outbound {};
+  std::unique_ptr<SPSCByteStream> _direct_inbound {};
+
+  //! Move what the owner has written into the outbound stream, closing the stream once the owner has shut it down
+  void _read_outbound();
+
+  //! Move reassembled bytes into the direct inbound ring, closing the ring once the inbound stream has finished
+  void _write_inbound();
+
   //! Main loop of TCPPeer thread
   void _tcp_main();
 
@@ -89,6 +120,8 @@ private:
 
   std::atomic_bool _abort { false }; //!< Flag used by the owner to force the TCPPeer thread to shut down
 
+  FileDescriptor _flush_event; //!< eventfd the owner signals to wake the TCPPeer thread for a flush()
+
   bool _inbound_shutdown { false }; //!< Has TCPMinnowSocket shut down the incoming data to the owner?
 
   bool _outbound_shutdown { false }; //!< Has the owner shut down the outbound data to the TCP connection?
@@ -118,6 +151,9 @@ using LossyTCPOverIPv4MinnowSocket = TCPMinnowSocket<LossyFdAdapter<TCPOverIPv4O
 //!   and [accept(2)](\ref man2::accept)
 //! - if TCPMinnowSocket is destructed while a TCP connection is open, the connection is
 //!   immediately terminated with a RST (call `wait_until_closed` to avoid this)
+//! - with use_direct_streams(), the owner exchanges bytes with the TCPPeer thread through lock-free
+//!   rings (SPSCByteStream) instead of a socket pair, so a chunk of data costs no system call unless one
+//!   side has to wake the other up
 
 //! Helper class that makes a TCPOverIPv4MinnowSocket behave more like a (kernel) TCPSocket
 class CS144TCPSocket : public TCPOverIPv4MinnowSocket
@@ -128,6 +164,9 @@ public:
   {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
+    tcp_config.adaptive_rto = true;
+    tcp_config.rack_tlp = true;
+    tcp_config.max_send_capacity = 4 << 20; // as Linux's largest tcp_wmem, so the peer's window can be filled
 
     FdAdapterConfig multiplexer_config;
     multiplexer_config.source = { "169.254.144.9", std::to_string( uint16_t( std::random_device()() ) ) };
@@ -4,11 +4,15 @@
 #include "parser.hh"
 #include "tun.hh"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstring>
 #include <exception>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -45,6 +49,72 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
       _datagram_adapter.tick( next_time - base_time );
       base_time = next_time;
     }
+
+    // The owner only signals the direct outbound ring when it pushes into an empty one, so bytes left behind
+    // because the outbound stream was full are picked up here once there is room again.
+    if ( _direct_outbound and not _outbound_shutdown and _tcp.value().active()
+         and _direct_outbound->bytes_buffered() and _tcp->outbound_writer().available_capacity() ) {
+      _read_outbound();
+      _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
+    }
+  }
+}
+
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_read_outbound()
+{
+  Writer& outbound = _tcp->outbound_writer();
+  if ( _direct_outbound ) {
+    // The outbound stream keeps each pushed string as a chunk, and the ring's space is reused as soon as it is
+    // popped, so copy everything that fits (at most two regions of the ring) into one string and move that in.
+    const uint64_t len = std::min( _direct_outbound->bytes_buffered(), outbound.available_capacity() );
+    if ( len ) {
+      std::string chunk;
+      chunk.reserve( len );
+      while ( chunk.size() < len ) {
+        const auto view = _direct_outbound->peek().substr( 0, len - chunk.size() );
+        chunk.append( view );
+        _direct_outbound->pop( view.size() );
+      }
+      outbound.push( std::move( chunk ) );
+    }
+    if ( _direct_outbound->has_error() ) {
+      outbound.set_error();
+    }
+  } else {
+    outbound.write_from( _thread_data );
+  }
+
+  if ( _direct_outbound ? _direct_outbound->is_finished() : _thread_data.eof() ) {
+    _tcp->outbound_writer().close();
+    _outbound_shutdown = true;
+
+    // debugging output:
+    std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
+              << " finished (" << _tcp.value().sender().sequence_numbers_in_flight() << " seqno"
+              << ( _tcp.value().sender().sequence_numbers_in_flight() == 1 ? "" : "s" ) << " still in flight).\n";
+  }
+}
+
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_write_inbound()
+{
+  Reader& inbound = _tcp->inbound_reader();
+  while ( inbound.bytes_buffered() and _direct_inbound->available_capacity() ) {
+    inbound.pop( _direct_inbound->push( inbound.peek() ) );
+  }
+
+  if ( ( inbound.is_finished() or inbound.has_error() ) and not _inbound_shutdown ) {
+    if ( inbound.has_error() ) {
+      _direct_inbound->set_error();
+    } else {
+      _direct_inbound->close();
+    }
+    _inbound_shutdown = true;
+
+    // debugging output:
+    std::cerr << "DEBUG: minnow inbound stream from " << _datagram_adapter.config().destination.to_string()
+              << " finished " << ( inbound.has_error() ? "uncleanly.\n" : "cleanly.\n" );
   }
 }
 
@@ -56,6 +126,7 @@ TCPMinnowSocket<AdaptT>::TCPMinnowSocket( std::pair<FileDescriptor, FileDescript
   : LocalStreamSocket( std::move( data_socket_pair.first ) )
   , _datagram_adapter( std::move( datagram_interface ) )
   , _thread_data( std::move( data_socket_pair.second ) )
+  , _flush_event( CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) )
 {
   _thread_data.set_blocking( false );
   set_blocking( false );
@@ -79,6 +150,8 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
   // 3) Incoming bytes reassembled by the Reassembler
   //    (needs to be read from the inbound_stream and written
   //    to the local stream socket back to the application)
+  //
+  // 4) A flush() requested by the owner (signalled on an eventfd)
 
   // rule 1: read from filtered packet stream and dump into TCPConnection
   _eventloop.add_rule(
@@ -90,8 +163,13 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
         _tcp->receive( std::move( seg.value() ), [&]( auto x ) { _datagram_adapter.write( x ); } );
       }
 
+      // the inbound ring has no writability to wait for, so hand new bytes to the owner right away
+      if ( _direct_inbound ) {
+        _write_inbound();
+      }
+
       // debugging output:
-      if ( _thread_data.eof() and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
+      if ( _outbound_shutdown and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
         std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
                   << " has been fully acknowledged.\n";
         _fully_acked = true;
@@ -99,28 +177,60 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     },
     [&] { return _tcp->active(); } );
 
+  // rule 4: flush the outbound stream when the owner asks
+  _eventloop.add_rule(
+    "flush TCPPeer",
+    _flush_event,
+    Direction::In,
+    [&] {
+      std::string buf( sizeof( uint64_t ), 0 );
+      _flush_event.read( buf );
+      // The owner wrote its bytes before asking for the flush, but they may still be in the socket pair.
+      if ( not _outbound_shutdown ) {
+        _read_outbound();
+      }
+      _tcp->flush( [&]( auto x ) { _datagram_adapter.write( x ); } );
+    },
+    [&] { return _tcp->active(); } );
+
+  if ( _direct_outbound ) {
+    // rules 2 and 3 with direct streams: the owner's pushes and pops are signalled by eventfds
+
+    // rule 2: move bytes from the direct outbound ring into the outbound buffer
+    _eventloop.add_rule(
+      "push bytes to TCPPeer",
+      _direct_outbound->data_event(),
+      Direction::In,
+      [&] {
+        _direct_outbound->clear_data_event();
+        _read_outbound();
+        _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
+      },
+      [&] {
+        return ( _tcp->active() ) and ( not _outbound_shutdown )
+               and ( _tcp->outbound_writer().available_capacity() > 0 );
+      } );
+
+    // rule 3: move bytes from the inbound stream into the direct inbound ring once the owner has made room
+    _eventloop.add_rule(
+      "read bytes from inbound stream",
+      _direct_inbound->space_event(),
+      Direction::In,
+      [&] {
+        _direct_inbound->clear_space_event();
+        _write_inbound();
+      },
+      [&] { return not _inbound_shutdown; } );
+    return;
+  }
+
   // rule 2: read from pipe into outbound buffer
   _eventloop.add_rule(
     "push bytes to TCPPeer",
     _thread_data,
     Direction::In,
     [&] {
-      std::string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
-
-      if ( _thread_data.eof() ) {
-        _tcp->outbound_writer().close();
-        _outbound_shutdown = true;
-
-        // debugging output:
-        std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
-                  << " finished (" << _tcp.value().sender().sequence_numbers_in_flight() << " seqno"
-                  << ( _tcp.value().sender().sequence_numbers_in_flight() == 1 ? "" : "s" )
-                  << " still in flight).\n";
-      }
-
+      _read_outbound();
       _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
     },
     [&] {
@@ -147,8 +257,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       // the pipe, handling the possibility of a partial
       // write (i.e., only pop what was actually written).
       if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
+        const auto bytes_written = _thread_data.write( inbound.peek_iov() );
         inbound.pop( bytes_written );
       }
 
@@ -206,10 +315,51 @@ TCPMinnowSocket<AdaptT>::~TCPMinnowSocket()
   }
 }
 
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::flush()
+{
+  const uint64_t one = 1;
+  std::array<char, sizeof( one )> buf {};
+  memcpy( buf.data(), &one, sizeof( one ) );
+  _flush_event.write( std::string_view { buf.data(), buf.size() } );
+}
+
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::use_direct_streams( uint64_t capacity )
+{
+  if ( _tcp ) {
+    throw std::runtime_error( "use_direct_streams() with TCPConnection already initialized" );
+  }
+
+  _direct_outbound = std::make_unique<SPSCByteStream>( capacity );
+  _direct_inbound = std::make_unique<SPSCByteStream>( capacity );
+}
+
+template<TCPDatagramAdapter AdaptT>
+SPSCByteStream& TCPMinnowSocket<AdaptT>::direct_outbound()
+{
+  if ( not _direct_outbound ) {
+    throw std::runtime_error( "direct_outbound() without use_direct_streams()" );
+  }
+  return *_direct_outbound;
+}
+
+template<TCPDatagramAdapter AdaptT>
+SPSCByteStream& TCPMinnowSocket<AdaptT>::direct_inbound()
+{
+  if ( not _direct_inbound ) {
+    throw std::runtime_error( "direct_inbound() without use_direct_streams()" );
+  }
+  return *_direct_inbound;
+}
+
 template<TCPDatagramAdapter AdaptT>
 void TCPMinnowSocket<AdaptT>::wait_until_closed()
 {
   shutdown( SHUT_RDWR );
+  if ( _direct_outbound ) {
+    _direct_outbound->close();
+  }
   if ( _tcp_thread.joinable() ) {
     std::cerr << "DEBUG: minnow waiting for clean shutdown... ";
     _tcp_thread.join();
@@ -282,6 +432,13 @@ void TCPMinnowSocket<AdaptT>::_tcp_main()
     }
     _tcp_loop( [] { return true; } );
     shutdown( SHUT_RDWR );
+    // wake an owner still waiting on a direct ring
+    if ( _direct_outbound and not _outbound_shutdown ) {
+      _direct_outbound->set_error();
+    }
+    if ( _direct_inbound and not _inbound_shutdown ) {
+      _direct_inbound->set_error();
+    }
     if ( not _tcp.value().active() ) {
       std::cerr << "DEBUG: minnow TCP connection finished "
                 << ( _tcp->inbound_reader().has_error() ? "uncleanly.\n" : "cleanly.\n" );
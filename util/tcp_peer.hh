@@ -7,6 +7,8 @@
 #include "tcp_sender.hh"
 #include "tcp_sender_message.hh"
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <optional>
 
@@ -18,7 +20,7 @@ class TCPPeer
   }
 
 public:
-  explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg ) {}
+  explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg ) { receiver_.set_max_capacity( cfg_.max_recv_capacity ); }
 
   Writer& outbound_writer() { return sender_.writer(); }
   Reader& inbound_reader() { return receiver_.reader(); }
@@ -27,11 +29,26 @@ public:
   using TransmitFunction = std::function<void( TCPMessage )>;
 
   /* Passthrough methods */
-  void push( const TransmitFunction& transmit ) { sender_.push( make_send( transmit ) ); }
+  void push( const TransmitFunction& transmit )
+  {
+    update_options_length();
+    sender_.push( make_send( transmit ) );
+  }
+  void flush( const TransmitFunction& transmit )
+  {
+    update_options_length();
+    sender_.flush( make_send( transmit ) );
+  }
   void tick( uint64_t t, const TransmitFunction& transmit )
   {
     cumulative_time_ += t;
+    update_options_length();
     sender_.tick( t, make_send( transmit ) );
+
+    // The delayed-ACK timer expired without any outgoing segment to carry the ACK.
+    if ( ack_deadline_.has_value() and cumulative_time_ >= ack_deadline_.value() ) {
+      send( sender_.make_empty_message(), transmit );
+    }
   }
   bool has_ackno() const { return receiver_.send().ackno.has_value(); }
 
@@ -56,25 +73,88 @@ public:
     // Record time in case this peer has to linger after streams finish.
     time_of_last_receipt_ = cumulative_time_;
 
-    // If SenderMessage occupies a sequence number, make sure to reply.
-    need_send_ |= ( msg.sender.sequence_length() > 0 );
-
     // If SenderMessage is a "keep-alive" (with intentionally invalid seqno), make sure to reply.
     // (N.B. orthodox TCP rules require a reply on any unacceptable segment.)
     const auto our_ackno = receiver_.send().ackno;
     need_send_ |= ( our_ackno.has_value() and msg.sender.seqno + 1 == our_ackno.value() );
 
-    // Did the inbound stream finish before the outbound stream? If so, no need to linger after streams finish.
-    if ( receiver_.writer().is_closed() and not sender_.reader().is_finished() ) {
-      linger_after_streams_finish_ = false;
+    // Segments that occupy sequence numbers are acknowledged, though in-order data may wait (see below).
+    const uint64_t sequence_length = msg.sender.sequence_length();
+    const bool delayable = sequence_length > 0 and ack_delay_ > 0 and not msg.sender.SYN
+                           and not msg.sender.FIN and our_ackno == msg.sender.seqno;
+    need_send_ |= ( sequence_length > 0 and not delayable );
+
+    // Timestamps: note the peer's offer on its SYN, and ignore the option on later segments unless both sides
+    // offered it (RFC 7323 3.2).
+    if ( msg.sender.SYN ) {
+      peer_timestamps_ = msg.sender.timestamp.has_value();
+      update_timestamps();
+    } else if ( not timestamps_ ) {
+      msg.sender.timestamp.reset();
+      msg.receiver.timestamp_echo.reset();
+    }
+
+    // SACK: likewise note the peer's offer, and ignore SACK blocks unless both sides offered it (RFC 2018 2).
+    if ( msg.sender.SYN ) {
+      peer_sack_permitted_ = msg.receiver.sack_permitted;
+      update_sack();
+    }
+    if ( not sack_ ) {
+      msg.receiver.sack.clear();
     }
 
     // Give incoming TCPSenderMessage to receiver.
+    const bool has_payload = not msg.sender.payload.empty();
     receiver_.receive( std::move( msg.sender ) );
 
+    // Did the inbound stream finish before we sent our FIN? If so, no need to linger after streams finish.
+    // (The outbound stream only finishes once the peer acknowledges everything, FIN included, so it cannot tell
+    // a passive close from a simultaneous one, where the peer's FIN arrives before its ACK of ours.)
+    if ( receiver_.writer().is_closed() and not sender_.fin_sent() ) {
+      linger_after_streams_finish_ = false;
+    }
+
+    // Receive-window auto-tuning, with an RTT sample from the echo of our own timestamp when there is one.
+    if ( has_payload ) {
+      std::optional<uint64_t> rtt_sample;
+      if ( timestamps_ and msg.receiver.timestamp_echo.has_value() ) {
+        rtt_sample = static_cast<uint32_t>( sender_.timestamp() - msg.receiver.timestamp_echo.value() );
+      }
+      receiver_.autotune( cumulative_time_, rtt_sample );
+    }
+
+    // Delayed ACKs (RFC 1122 4.2.3.2, RFC 5681 4.2): in-order data is acknowledged with every second segment or
+    // when the timer expires, whichever comes first. Data that was out of order, a duplicate, or filled a hole
+    // is acknowledged at once so the sender learns about it.
+    if ( delayable ) {
+      const auto new_ackno = receiver_.send().ackno;
+      if ( new_ackno != our_ackno.value() + static_cast<uint32_t>( sequence_length ) ) {
+        need_send_ = true;
+      } else if ( ++unacked_segments_ >= 2 ) {
+        need_send_ = true;
+      } else if ( not ack_deadline_.has_value() ) {
+        ack_deadline_ = cumulative_time_ + ack_delay_;
+      }
+    }
+
+    // Window scaling: note the peer's offer on its SYN, and scale the window of any later segment.
+    if ( msg.sender.SYN ) {
+      peer_syn_seen_ = true;
+      peer_window_scale_ = msg.receiver.window_scale;
+      update_window_scaling();
+      // Never send a segment bigger than the peer can take; without the option, assume the RFC 9293 default.
+      sender_.set_peer_mss( msg.receiver.mss.value_or( TCPConfig::DEFAULT_MSS ) );
+    } else if ( window_scaling_ ) {
+      msg.receiver.window_size <<= peer_window_scale_.value();
+    }
+
     // Give incoming TCPReceiverMessage to sender.
     sender_.receive( msg.receiver );
 
+    // The ack may have opened the window or reported holes to repair; any segment sent here carries the ackno,
+    // and so also takes the place of a delayed ACK.
+    push( transmit );
+
     // Send reply if needed.
     if ( need_send_ ) {
       send( sender_.make_empty_message(), transmit );
@@ -87,18 +167,112 @@ public:
 
 private:
   TCPConfig cfg_;
-  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_.isn, cfg_.rt_timeout };
-  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+  TCPSender sender_ { ByteStream { cfg_.send_capacity, ByteStream::Mode::Chunked }, cfg_ };
+  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity, ByteStream::Mode::Chunked } } };
 
   bool need_send_ {};
+  //! the peer's TLP timeout allows for at most MAX_ACK_DELAY (RFC 8985), so a longer delay would trigger probes
+  uint16_t ack_delay_ { std::min( cfg_.ack_delay, TCPConfig::MAX_ACK_DELAY ) };
+  unsigned unacked_segments_ {};            //!< in-order segments received since our last ACK
+  std::optional<uint64_t> ack_deadline_ {}; //!< when a delayed ACK must go out
 
   void send( const TCPSenderMessage& sender_message, const TransmitFunction& transmit )
   {
     TCPMessage msg { sender_message, receiver_.send() };
+    if ( sender_message.SYN ) {
+      // Offer window scaling on our SYN, unless we are answering a SYN that did not offer it (RFC 7323 1.3).
+      // The window in a SYN segment is never scaled.
+      if ( not peer_syn_seen_ or peer_window_scale_.has_value() ) {
+        msg.receiver.window_scale = window_scale_;
+        window_scale_offered_ = true;
+        update_window_scaling();
+      }
+      msg.receiver.window_size = std::min( msg.receiver.window_size, uint32_t { UINT16_MAX } );
+      // Tell the peer the largest segment we can receive (RFC 9293 3.7.1).
+      msg.receiver.mss = static_cast<uint16_t>( std::min( cfg_.mss, size_t { UINT16_MAX } ) );
+    } else if ( window_scaling_ ) {
+      msg.receiver.window_size >>= window_scale_;
+    }
+    // Likewise offer timestamps on our SYN unless answering a SYN without them; later segments carry them
+    // only once both sides have offered.
+    if ( sender_message.SYN and ( not peer_syn_seen_ or peer_timestamps_ ) ) {
+      timestamps_offered_ = true;
+      update_timestamps();
+    } else if ( not timestamps_ ) {
+      msg.sender.timestamp.reset();
+      msg.receiver.timestamp_echo.reset();
+    }
+    // And SACK: offer it on our SYN unless answering a SYN without it, and send blocks only once both have.
+    if ( sender_message.SYN and ( not peer_syn_seen_ or peer_sack_permitted_ ) ) {
+      msg.receiver.sack_permitted = true;
+      sack_offered_ = true;
+      update_sack();
+    }
+    if ( not sack_ ) {
+      msg.receiver.sack.clear();
+    }
+    // Every segment carries the latest ackno, so nothing is left to acknowledge.
+    if ( msg.receiver.ackno.has_value() ) {
+      unacked_segments_ = 0;
+      ack_deadline_.reset();
+      receiver_.ack_sent();
+    }
     transmit( std::move( msg ) );
     need_send_ = false;
   }
 
+  //! Smallest shift that lets the 16-bit window field cover the whole receive capacity
+  static uint8_t window_scale_for( size_t capacity )
+  {
+    uint8_t shift = 0;
+    while ( shift < TCPReceiverMessage::MAX_WINDOW_SCALE and ( capacity >> shift ) > UINT16_MAX ) {
+      shift++;
+    }
+    return shift;
+  }
+
+  //! Scaling takes effect once both SYNs have carried the option
+  void update_window_scaling()
+  {
+    window_scaling_ = window_scale_offered_ and peer_window_scale_.has_value();
+    if ( window_scaling_ ) {
+      receiver_.set_window_scale( window_scale_ );
+    }
+  }
+
+  //! Timestamps are used once both SYNs have carried the option
+  void update_timestamps() { timestamps_ = timestamps_offered_ and peer_timestamps_; }
+
+  //! SACK blocks are sent and acted on once both SYNs have carried SACK-permitted
+  void update_sack() { sack_ = sack_offered_ and peer_sack_permitted_; }
+
+  //! Tell the sender how many bytes of options its segments will carry (the timestamps, and the SACK blocks our
+  //! receiver has to report), so that a full segment with them still fits the MSS
+  void update_options_length()
+  {
+    TCPSegment seg { .message { sender_.make_empty_message(), receiver_.send() } };
+    if ( not timestamps_ ) {
+      seg.message.sender.timestamp.reset();
+    }
+    if ( not sack_ ) {
+      seg.message.receiver.sack.clear();
+    }
+    sender_.set_options_length( seg.header_length() - 20 /* tcp header len without options */ );
+  }
+
+  //! shift applied to the windows we send, enough for the largest the receive window may grow to
+  uint8_t window_scale_ { window_scale_for( std::max( cfg_.recv_capacity, cfg_.max_recv_capacity ) ) };
+  bool window_scale_offered_ {};                                     //!< did our SYN carry the option?
+  bool peer_syn_seen_ {};
+  std::optional<uint8_t> peer_window_scale_ {}; //!< shift the peer applies to the windows it sends
+  bool window_scaling_ {};                       //!< both sides offered the option
+  bool timestamps_offered_ {};                   //!< did our SYN carry the timestamps option?
+  bool peer_timestamps_ {};                      //!< did the peer's SYN carry it?
+  bool timestamps_ {};                           //!< both sides offered the timestamps option
+  bool sack_offered_ {};                         //!< did our SYN carry SACK-permitted?
+  bool peer_sack_permitted_ {};                  //!< did the peer's SYN carry it?
+  bool sack_ {};                                 //!< both sides offered SACK
+
   bool linger_after_streams_finish_ { true }; // one peer may need to linger to make sure all closure conditions met
   uint64_t cumulative_time_ {};
   uint64_t time_of_last_receipt_ {};
@@ -2,26 +2,61 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains three fields:
+ * It contains eight fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
  *
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
- *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
- *    the <cstdint> header).
+ *    to receive, starting from the ackno if present. On the wire the field is 16 bits, so without
+ *    window scaling the maximum value is 65,535 (UINT16_MAX from the <cstdint> header); with it,
+ *    the TCPPeer shifts the value in and out of the 16-bit field.
  *
  * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) Selective acknowledgment (SACK) blocks: ranges of sequence numbers beyond the ackno that the receiver
+ *    already holds (RFC 2018). The first block covers the most recently received segment; at most
+ *    MAX_SACK_BLOCKS are carried.
+ *
+ * 5) The window scale (RFC 7323), only meaningful on a SYN segment: the shift count that the sender of
+ *    this message will apply to the window sizes it advertises once both sides have offered the option.
+ *
+ * 6) The maximum segment size (MSS), only meaningful on a SYN segment: the largest payload the sender of this
+ *    message is willing to receive in one segment.
+ *
+ * 7) The timestamp echo (TSecr of the RFC 7323 timestamps option): the most recent timestamp of the peer that
+ *    this receiver accepted, so the peer's sender can compute an RTT sample from any acknowledgment.
+ *
+ * 8) SACK-permitted, only meaningful on a SYN segment: the sender of this message understands SACK blocks.
+ *    Neither side may send SACK blocks unless both SYNs carried it (RFC 2018 2).
  */
 
+struct SACKBlock
+{
+  Wrap32 left { 0 };  // first sequence number of the block
+  Wrap32 right { 0 }; // sequence number just past the end of the block
+
+  bool operator==( const SACKBlock& other ) const = default;
+};
+
 struct TCPReceiverMessage
 {
+  static constexpr size_t MAX_SACK_BLOCKS = 4;
+  static constexpr uint8_t MAX_WINDOW_SCALE = 14;
+
   std::optional<Wrap32> ackno {};
-  uint16_t window_size {};
+  uint32_t window_size {};
   bool RST {};
+  std::vector<SACKBlock> sack {};
+  std::optional<uint8_t> window_scale {};
+  std::optional<uint16_t> mss {};
+  std::optional<uint32_t> timestamp_echo {};
+  bool sack_permitted {};
 };
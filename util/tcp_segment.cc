@@ -2,12 +2,176 @@
 #include "checksum.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 
 static constexpr uint32_t TCPHeaderMinLen = 5; // 32-bit words
 
+// TCP option kinds
+static constexpr uint8_t TCPOptionEnd = 0;
+static constexpr uint8_t TCPOptionNop = 1;
+static constexpr uint8_t TCPOptionMSS = 2;
+static constexpr uint8_t TCPOptionWindowScale = 3;
+static constexpr uint8_t TCPOptionSACKPermitted = 4;
+static constexpr uint8_t TCPOptionSACK = 5;
+static constexpr uint8_t TCPOptionTimestamps = 8;
+
+static constexpr uint8_t TCPOptionSACKBlockLen = 8;  // two 32-bit sequence numbers
+static constexpr uint8_t TCPOptionTimestampsLen = 10; // kind, length, TSval, TSecr
+static constexpr uint64_t TCPOptionsMaxLen = 40;      // the data offset field allows at most 15 words of header
+
 using namespace std;
 
+namespace {
+
+// Parse `len` bytes of TCP options, keeping the ones we understand and skipping the rest
+void parse_options( Parser& parser, uint64_t len, TCPMessage& message )
+{
+  uint8_t kind {};
+  uint8_t option_len {};
+  uint32_t raw32 {};
+
+  while ( len > 0 and not parser.has_error() ) {
+    parser.integer( kind );
+    len--;
+    if ( kind == TCPOptionEnd ) {
+      parser.remove_prefix( len ); // the rest of the option space is padding
+      return;
+    }
+    if ( kind == TCPOptionNop ) {
+      continue;
+    }
+
+    parser.integer( option_len );
+    if ( len == 0 or option_len < 2 or option_len - 1U > len ) {
+      parser.set_error();
+      return;
+    }
+    len -= option_len - 1U;
+    const uint64_t body_len = option_len - 2U;
+
+    switch ( kind ) {
+      case TCPOptionSACK:
+        if ( body_len % TCPOptionSACKBlockLen ) {
+          parser.set_error();
+          return;
+        }
+        for ( uint64_t i = 0; i < body_len / TCPOptionSACKBlockLen; i++ ) {
+          SACKBlock block;
+          parser.integer( raw32 );
+          block.left = Wrap32 { raw32 };
+          parser.integer( raw32 );
+          block.right = Wrap32 { raw32 };
+          message.receiver.sack.push_back( block );
+        }
+        break;
+
+      case TCPOptionMSS: {
+        if ( body_len != 2 ) {
+          parser.set_error();
+          return;
+        }
+        uint16_t mss {};
+        parser.integer( mss );
+        message.receiver.mss = mss;
+        break;
+      }
+
+      case TCPOptionSACKPermitted:
+        if ( body_len != 0 ) {
+          parser.set_error();
+          return;
+        }
+        message.receiver.sack_permitted = true;
+        break;
+
+      case TCPOptionWindowScale: {
+        if ( body_len != 1 ) {
+          parser.set_error();
+          return;
+        }
+        uint8_t shift {};
+        parser.integer( shift );
+        // RFC 7323 2.3: a shift count above 14 is treated as 14
+        message.receiver.window_scale = min( shift, TCPReceiverMessage::MAX_WINDOW_SCALE );
+        break;
+      }
+
+      case TCPOptionTimestamps:
+        if ( option_len != TCPOptionTimestampsLen ) {
+          parser.set_error();
+          return;
+        }
+        parser.integer( raw32 );
+        message.sender.timestamp = raw32;
+        parser.integer( raw32 );
+        // RFC 7323 3.2: TSecr is only valid when the ACK bit is set
+        if ( message.receiver.ackno.has_value() ) {
+          message.receiver.timestamp_echo = raw32;
+        }
+        break;
+
+      default:
+        parser.remove_prefix( body_len );
+        break;
+    }
+  }
+}
+
+// The window scale option is only allowed on a SYN segment
+bool window_scale_to_send( const TCPMessage& message )
+{
+  return message.sender.SYN and message.receiver.window_scale.has_value();
+}
+
+// Like the window scale, the MSS option is only allowed on a SYN segment
+bool mss_to_send( const TCPMessage& message )
+{
+  return message.sender.SYN and message.receiver.mss.has_value();
+}
+
+// So is SACK-permitted
+bool sack_permitted_to_send( const TCPMessage& message )
+{
+  return message.sender.SYN and message.receiver.sack_permitted;
+}
+
+// Length in bytes of the options other than SACK (always a multiple of 4)
+uint64_t fixed_options_length( const TCPMessage& message )
+{
+  uint64_t len = mss_to_send( message ) ? 4 : 0; // kind, length, MSS
+  if ( window_scale_to_send( message ) ) {
+    len += 4; // NOP, kind, length, shift count
+  }
+  if ( sack_permitted_to_send( message ) ) {
+    len += 4; // NOP, NOP, kind, length
+  }
+  if ( message.sender.timestamp.has_value() ) {
+    len += 2 + TCPOptionTimestampsLen; // NOP, NOP, kind, length, TSval, TSecr
+  }
+  return len;
+}
+
+// SACK blocks get whatever option space is left (three blocks alongside timestamps, RFC 2018 3)
+size_t sack_blocks_to_send( const TCPMessage& message )
+{
+  if ( not message.receiver.ackno.has_value() ) {
+    return 0;
+  }
+  const uint64_t room = ( TCPOptionsMaxLen - fixed_options_length( message ) - 4 ) / TCPOptionSACKBlockLen;
+  return min( { message.receiver.sack.size(), TCPReceiverMessage::MAX_SACK_BLOCKS, room } );
+}
+
+// Length in bytes of the options that serialize() writes (always a multiple of 4)
+uint64_t options_length( const TCPMessage& message )
+{
+  const size_t sack_blocks = sack_blocks_to_send( message );
+  const uint64_t len = sack_blocks ? 4 + sack_blocks * TCPOptionSACKBlockLen : 0; // NOP, NOP, kind, length, blocks
+  return len + fixed_options_length( message );
+}
+
+} // namespace
+
 void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
 {
   /* verify checksum */
@@ -43,15 +207,22 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
   message.sender.SYN = octet & 0b0000'0010;
   message.sender.FIN = octet & 0b0000'0001;
 
-  parser.integer( message.receiver.window_size );
+  parser.integer( raw16 );
+  message.receiver.window_size = raw16;
   parser.integer( udinfo.cksum );
   parser.integer( raw16 ); // urgent pointer
 
-  // skip any options or anything extra in the header
   if ( data_offset < TCPHeaderMinLen ) {
     parser.set_error();
+    return;
   }
-  parser.remove_prefix( data_offset * 4 - TCPHeaderMinLen * 4 );
+  message.receiver.sack.clear();
+  message.receiver.window_scale.reset();
+  message.receiver.mss.reset();
+  message.receiver.sack_permitted = false;
+  message.sender.timestamp.reset();
+  message.receiver.timestamp_echo.reset();
+  parse_options( parser, data_offset * 4 - TCPHeaderMinLen * 4, message );
 
   parser.all_remaining( message.sender.payload );
 }
@@ -68,17 +239,59 @@ void TCPSegment::serialize( Serializer& serializer ) const
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { message.sender.seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { message.receiver.ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { TCPHeaderMinLen << 4 } ); // data offset
+  const uint64_t options_len = options_length( message );
+  serializer.integer( static_cast<uint8_t>( ( TCPHeaderMinLen + options_len / 4 ) << 4 ) ); // data offset
   const bool reset = message.sender.RST or message.receiver.RST;
   const uint8_t flags = ( message.receiver.ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( message.sender.SYN ? 0b0000'0010U : 0 ) | ( message.sender.FIN ? 0b0000'0001U : 0 );
   serializer.integer( flags );
-  serializer.integer( message.receiver.window_size );
+  serializer.integer( static_cast<uint16_t>( min( message.receiver.window_size, uint32_t { UINT16_MAX } ) ) );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
+
+  if ( mss_to_send( message ) ) {
+    serializer.integer( TCPOptionMSS );
+    serializer.integer( uint8_t { 4 } );
+    serializer.integer( message.receiver.mss.value() );
+  }
+  if ( window_scale_to_send( message ) ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionWindowScale );
+    serializer.integer( uint8_t { 3 } );
+    serializer.integer( message.receiver.window_scale.value() );
+  }
+  if ( sack_permitted_to_send( message ) ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionSACKPermitted );
+    serializer.integer( uint8_t { 2 } );
+  }
+  if ( message.sender.timestamp.has_value() ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionTimestamps );
+    serializer.integer( TCPOptionTimestampsLen );
+    serializer.integer( message.sender.timestamp.value() );
+    serializer.integer( message.receiver.timestamp_echo.value_or( 0 ) );
+  }
+  if ( const size_t sack_blocks = sack_blocks_to_send( message ) ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionSACK );
+    serializer.integer( static_cast<uint8_t>( 2 + sack_blocks * TCPOptionSACKBlockLen ) );
+    for ( size_t i = 0; i < sack_blocks; i++ ) {
+      serializer.integer( Wrap32Serializable { message.receiver.sack[i].left }.raw_value() );
+      serializer.integer( Wrap32Serializable { message.receiver.sack[i].right }.raw_value() );
+    }
+  }
   serializer.buffer( message.sender.payload );
 }
 
+uint64_t TCPSegment::header_length() const
+{
+  return TCPHeaderMinLen * 4 + options_length( message );
+}
+
 void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
 {
   udinfo.cksum = 0;
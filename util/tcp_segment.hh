@@ -18,6 +18,7 @@ struct TCPSegment
 
   void parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum );
   void serialize( Serializer& serializer ) const;
+  uint64_t header_length() const; // header plus the options serialize() writes, in bytes
 
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
 };